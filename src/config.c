@@ -25,15 +25,18 @@
 #include <dirent.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include "client.h"
 #include "config_keyword.h"
+#include "dns.h"
 #include "http.h"
 #include "ip_range.h"
 #include "ip_list.h"
 #include "mbuf.h"
 #include "port.h"
 #include "socket.h"
+#include "tcp_cc.h"
 #include "udp.h"
 #include "version.h"
 #include "vxlan.h"
@@ -88,6 +91,20 @@ static int config_parse_disable_ack(int argc, char *argv[], void *data);
 static int config_parse_retransmit_timeout(int argc, char *argv[], void *data);
 static int config_parse_neigh_ignore(int argc, char *argv[], void *data);
 static int config_parse_flow_isolate(int argc, char *argv[], void *data);
+static int config_parse_socket_table(int argc, char *argv[], void *data);
+static int config_parse_adaptive_rto(int argc, char *argv[], void *data);
+static int config_parse_sack(int argc, char *argv[], void *data);
+static int config_parse_congestion_control(int argc, char *argv[], void *data);
+static int config_parse_tso(int argc, char *argv[], void *data);
+static int config_parse_gro(int argc, char *argv[], void *data);
+static int config_parse_tx_split(int argc, char *argv[], void *data);
+static int config_parse_ack_delay(int argc, char *argv[], void *data);
+static int config_parse_timestamps(int argc, char *argv[], void *data);
+static int config_parse_syn_cookie(int argc, char *argv[], void *data);
+static int config_parse_rx_reorder(int argc, char *argv[], void *data);
+static int config_parse_udp_seq(int argc, char *argv[], void *data);
+static int config_parse_dns(int argc, char *argv[], void *data);
+static int config_parse_dns_names(int argc, char *argv[], void *data);
 
 #define _DEFAULT_STR(s) #s
 #define DEFAULT_STR(s)  _DEFAULT_STR(s)
@@ -116,7 +133,8 @@ static struct config_keyword g_config_keywords[] = {
     {"payload_random", config_parse_payload_random, ""},
     {"payload_size", config_parse_payload_size, "Number [Number Number ...]"},
     {"payload_file", config_parse_payload_file, "Path"},
-    {"send_window", config_parse_send_window, "Number["DEFAULT_STR(SEND_WINDOW_MIN) "-" DEFAULT_STR(SEND_WINDOW_MAX)"] default " DEFAULT_STR(SEND_WINDOW_DEFAULT)},
+    {"send_window", config_parse_send_window, "Number["DEFAULT_STR(SEND_WINDOW_MIN) "-" DEFAULT_STR(SEND_WINDOW_MAX)"] default " DEFAULT_STR(SEND_WINDOW_DEFAULT)
+                ", up to " DEFAULT_STR(SEND_WINDOW_CC_MAX) " with congestion_control"},
     {"packet_size", config_parse_packet_size, "Number"},
     {"mss", config_parse_mss, "Number, default 1460"},
     {"protocol", config_parse_protocol, "http/tcp/udp, default tcp"},
@@ -145,8 +163,26 @@ static struct config_keyword g_config_keywords[] = {
     {"log_level", config_parse_log_level, "error|warn|info|debug, default error"},
     {"disable_ack", config_parse_disable_ack, ""},
     {"retransmit_timeout", config_parse_retransmit_timeout, "Seconds[" DEFAULT_STR(RTO_MIN)"-" DEFAULT_STR(RTO_MAX)"], default " DEFAULT_STR(RTO_DEFAULT)},
+    {"adaptive_rto", config_parse_adaptive_rto, "[MinimumMilliseconds[1-" DEFAULT_STR(RTO_MIN_MS_MAX) "]], default "
+                DEFAULT_STR(RTO_MIN_MS_DEFAULT)},
+    {"sack", config_parse_sack, ""},
+    {"congestion_control", config_parse_congestion_control, "newreno|cubic"},
+    {"tso", config_parse_tso, ""},
+    {"gro", config_parse_gro, ""},
+    {"tx_split", config_parse_tx_split, ""},
+    {"ack_delay", config_parse_ack_delay, "Time(us/ms, up to 500ms) [Segments[1-" DEFAULT_STR(ACK_DELAY_SEGS_MAX) "]], default segments "
+                DEFAULT_STR(ACK_DELAY_SEGS_DEFAULT) ", eg 40ms 2"},
+    {"timestamps", config_parse_timestamps, ""},
+    {"syn_cookie", config_parse_syn_cookie, ""},
+    {"udp_seq", config_parse_udp_seq, ""},
+    {"dns", config_parse_dns, "[Answers[0-" DEFAULT_STR(DNS_ANSWERS_MAX) "]], default 1"},
+    {"dns_names", config_parse_dns_names, "Domain Number | Path, eg example.com 1m"},
+    {"rx_reorder", config_parse_rx_reorder, "Depth[1-" DEFAULT_STR(TCP_REORDER_DEPTH_MAX) "] [Buffers], default buffers "
+                    DEFAULT_STR(TCP_REORDER_NUM_DEFAULT)},
     {"neigh_ignore", config_parse_neigh_ignore, ""},
     {"flow_isolate", config_parse_flow_isolate, ""},
+    {"socket_table", config_parse_socket_table, "dense|sparse|hash [Number], default dense, "
+                "eg hash 4m (sockets per worker, default 1m)"},
     {NULL, NULL, NULL}
 };
 
@@ -1019,15 +1055,11 @@ void config_set_payload(struct config *cfg, char *data, int len, int new_line)
     data[len] = 0;
 }
 
+/* read the head of the file into 'buf', and return the size of the file */
 static int config_read_payload_file(struct config *cfg, char *buf, int buf_size)
 {
     FILE *fp = NULL;
-    int ret = 0;
-
-    if (cfg->payload_path[0]) {
-        printf("Error: duplicate payload_path\n");
-        return -1;
-    }
+    struct stat st;
 
     fp = fopen(cfg->payload_path, "r");
     if (fp == NULL) {
@@ -1035,10 +1067,26 @@ static int config_read_payload_file(struct config *cfg, char *buf, int buf_size)
         return -1;
     }
 
-    ret = fread(buf, 1, buf_size, fp);
+    if (fstat(fileno(fp), &st) < 0) {
+        printf("Error: cannot stat file: %s\n", cfg->payload_path);
+        fclose(fp);
+        return -1;
+    }
+
+    if (st.st_size > PAYLOAD_SIZE_MAX) {
+        printf("Error: 'payload_file' is larger than %lu\n", PAYLOAD_SIZE_MAX);
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(buf, 1, buf_size - 1, fp) == 0) {
+        printf("Error: empty file: %s\n", cfg->payload_path);
+        fclose(fp);
+        return -1;
+    }
     fclose(fp);
 
-    return ret;
+    return st.st_size;
 }
 
 static int config_parse_payload_random(int argc, __rte_unused char *argv[], void *data)
@@ -1127,7 +1175,8 @@ static int config_parse_send_window(int argc, char *argv[], void *data)
     }
 
     send_window = config_parse_number(argv[1], true, true);
-    if ((send_window < SEND_WINDOW_MIN) || (send_window > SEND_WINDOW_MAX)) {
+    /* see config_check_congestion_control() */
+    if ((send_window < SEND_WINDOW_MIN) || (send_window > SEND_WINDOW_CC_MAX)) {
         return -1;
     }
 
@@ -1686,6 +1735,308 @@ static int config_parse_retransmit_timeout(int argc, char *argv[], void *data)
     return 0;
 }
 
+static int config_parse_adaptive_rto(int argc, char *argv[], void *data)
+{
+    int val = RTO_MIN_MS_DEFAULT;
+    struct config *cfg = data;
+
+    if ((argc != 1) && (argc != 2)) {
+        return -1;
+    }
+
+    if (cfg->adaptive_rto) {
+        printf("Error: duplicate adaptive_rto\n");
+        return -1;
+    }
+
+    if (argc == 2) {
+        val = atoi(argv[1]);
+        if ((val < 1) || (val > RTO_MIN_MS_MAX)) {
+            return -1;
+        }
+    }
+
+    cfg->adaptive_rto = true;
+    cfg->rto_min_ms = val;
+    return 0;
+}
+
+static int config_parse_sack(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->sack) {
+        printf("Error: duplicate sack\n");
+        return -1;
+    }
+
+    cfg->sack = true;
+    return 0;
+}
+
+static int config_parse_congestion_control(int argc, char *argv[], void *data)
+{
+    int id = 0;
+    struct config *cfg = data;
+
+    if (argc != 2) {
+        return -1;
+    }
+
+    if (cfg->tcp_cc != TCP_CC_NONE) {
+        printf("Error: duplicate congestion_control\n");
+        return -1;
+    }
+
+    id = tcp_cc_find(argv[1]);
+    if (id < 0) {
+        printf("Error: unknown congestion_control '%s'\n", argv[1]);
+        return -1;
+    }
+
+    cfg->tcp_cc = id;
+    return 0;
+}
+
+static int config_parse_tso(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->tso) {
+        printf("Error: duplicate tso\n");
+        return -1;
+    }
+
+    cfg->tso = true;
+    return 0;
+}
+
+static int config_parse_gro(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->gro) {
+        printf("Error: duplicate gro\n");
+        return -1;
+    }
+
+    cfg->gro = true;
+    return 0;
+}
+
+static int config_parse_tx_split(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->tx_split) {
+        printf("Error: duplicate tx_split\n");
+        return -1;
+    }
+
+    cfg->tx_split = true;
+    return 0;
+}
+
+static int config_parse_timestamps(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->timestamps) {
+        printf("Error: duplicate timestamps\n");
+        return -1;
+    }
+
+    cfg->timestamps = true;
+    return 0;
+}
+
+static int config_parse_syn_cookie(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->syn_cookie) {
+        printf("Error: duplicate syn_cookie\n");
+        return -1;
+    }
+
+    cfg->syn_cookie = true;
+    return 0;
+}
+
+static int config_parse_udp_seq(int argc, __rte_unused char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    if (argc != 1) {
+        return -1;
+    }
+
+    if (cfg->udp_seq) {
+        printf("Error: duplicate udp_seq\n");
+        return -1;
+    }
+
+    cfg->udp_seq = true;
+    return 0;
+}
+
+static int config_parse_dns(int argc, char *argv[], void *data)
+{
+    int answers = 1;
+    struct config *cfg = data;
+
+    if ((argc != 1) && (argc != 2)) {
+        return -1;
+    }
+
+    if (cfg->dns) {
+        printf("Error: duplicate dns\n");
+        return -1;
+    }
+
+    if (argc == 2) {
+        answers = config_parse_number(argv[1], false, false);
+        if ((answers < 0) || (answers > DNS_ANSWERS_MAX)) {
+            return -1;
+        }
+    }
+
+    cfg->dns = true;
+    cfg->dns_answers = answers;
+    return 0;
+}
+
+static int config_parse_dns_names(int argc, char *argv[], void *data)
+{
+    int num = 0;
+    struct config *cfg = data;
+
+    if ((argc != 2) && (argc != 3)) {
+        return -1;
+    }
+
+    if (cfg->dns_names[0]) {
+        printf("Error: duplicate dns_names\n");
+        return -1;
+    }
+
+    if (strlen(argv[1]) >= PAYLOAD_PATH_MAX) {
+        printf("Error: large dns_names\n");
+        return -1;
+    }
+
+    if (argc == 3) {
+        num = config_parse_number(argv[2], false, true);
+        if ((num < 1) || (num > DNS_NAME_NUM_MAX)) {
+            return -1;
+        }
+    }
+
+    strcpy(cfg->dns_names, argv[1]);
+    cfg->dns_name_num = num;
+    return 0;
+}
+
+static int config_parse_rx_reorder(int argc, char *argv[], void *data)
+{
+    int depth = 0;
+    int num = TCP_REORDER_NUM_DEFAULT;
+    struct config *cfg = data;
+
+    if ((argc != 2) && (argc != 3)) {
+        return -1;
+    }
+
+    if (cfg->rx_reorder) {
+        printf("Error: duplicate rx_reorder\n");
+        return -1;
+    }
+
+    depth = config_parse_number(argv[1], false, false);
+    if ((depth < 1) || (depth > TCP_REORDER_DEPTH_MAX)) {
+        return -1;
+    }
+
+    if (argc == 3) {
+        num = config_parse_number(argv[2], false, false);
+        if ((num < 1) || (num > TCP_REORDER_NUM_MAX)) {
+            return -1;
+        }
+    }
+
+    cfg->rx_reorder = depth;
+    cfg->rx_reorder_num = num;
+    return 0;
+}
+
+static int config_parse_ack_delay(int argc, char *argv[], void *data)
+{
+    char *p = NULL;
+    int val = 0;
+    int segs = ACK_DELAY_SEGS_DEFAULT;
+    struct config *cfg = data;
+
+    if ((argc != 2) && (argc != 3)) {
+        return -1;
+    }
+
+    if (cfg->ack_delay_us) {
+        printf("Error: duplicate ack_delay\n");
+        return -1;
+    }
+
+    p = config_str_find_nondigit(argv[1], false);
+    if (p == NULL) {
+        return -1;
+    }
+
+    val = atoi(argv[1]);
+    if (strcmp(p, "ms") == 0) {
+        val *= 1000;
+    } else if (strcmp(p, "us") != 0) {
+        return -1;
+    }
+
+    if ((val <= 0) || (val > ACK_DELAY_US_MAX)) {
+        return -1;
+    }
+
+    if (argc == 3) {
+        segs = atoi(argv[2]);
+        if ((segs < 1) || (segs > ACK_DELAY_SEGS_MAX)) {
+            return -1;
+        }
+    }
+
+    cfg->ack_delay_us = val;
+    cfg->ack_delay_segs = segs;
+    return 0;
+}
+
 static int config_parse_neigh_ignore(int argc, char *argv[], void *data)
 {
     struct config *cfg = data;
@@ -1719,6 +2070,49 @@ static int config_parse_flow_isolate(int argc, char *argv[], void *data)
     return 0;
 }
 
+static int config_parse_socket_table(int argc, char *argv[], void *data)
+{
+    struct config *cfg = data;
+
+    int num = 0;
+
+    if ((argc != 2) && (argc != 3)) {
+        return -1;
+    }
+
+    if (cfg->socket_table) {
+        printf("Error: duplicate socket_table\n");
+        return -1;
+    }
+
+    if (strcmp(argv[1], "dense") == 0) {
+        cfg->socket_table = SOCKET_TABLE_DENSE;
+    } else if (strcmp(argv[1], "sparse") == 0) {
+        cfg->socket_table = SOCKET_TABLE_SPARSE;
+    } else if (strcmp(argv[1], "hash") == 0) {
+        cfg->socket_table = SOCKET_TABLE_HASH;
+        cfg->socket_hash_num = SOCKET_HASH_NUM_DEFAULT;
+    } else {
+        printf("Error: unknown socket_table %s\n", argv[1]);
+        return -1;
+    }
+
+    if (argc == 3) {
+        if (cfg->socket_table != SOCKET_TABLE_HASH) {
+            return -1;
+        }
+
+        num = config_parse_number(argv[2], true, true);
+        if ((num <= 0) || (num > SOCKET_HASH_NUM_MAX)) {
+            printf("Error: bad socket_table hash size %s\n", argv[2]);
+            return -1;
+        }
+        cfg->socket_hash_num = num;
+    }
+
+    return 0;
+}
+
 static void config_manual(void)
 {
     config_keyword_help(g_config_keywords);
@@ -2278,10 +2672,10 @@ static int config_check_payload_size(struct config *cfg)
         payload_size = cfg->payload_size[i];
         if ((cfg->protocol == IPPROTO_TCP) && (cfg->server)) {
             if (payload_size > cfg->mss) {
-                payload_size = ((payload_size + cfg->mss - 1) / cfg->mss) * cfg->mss;
-                cfg->payload_size[i] = payload_size;
-                if (cfg->send_window == 0) {
-                    cfg->send_window = SEND_WINDOW_DEFAULT;
+                /* an object ends with a short segment */
+                if (!cfg->payload_object) {
+                    payload_size = ((payload_size + cfg->mss - 1) / cfg->mss) * cfg->mss;
+                    cfg->payload_size[i] = payload_size;
                 }
                 large = 1;
             }
@@ -2292,11 +2686,22 @@ static int config_check_payload_size(struct config *cfg)
         }
     }
 
-    if (large == 0) {
-        cfg->send_window = 0;
+    /* pipelined responses are sent in the window too */
+    if ((cfg->protocol == IPPROTO_TCP) && cfg->server && cfg->pipeline) {
+        large = 1;
     }
 
-    return 0;
+    if (large == 0) {
+        cfg->send_window = 0;
+    } else if (cfg->send_window == 0) {
+        if (cfg->tcp_cc != TCP_CC_NONE) {
+            cfg->send_window = SEND_WINDOW_CC_MAX;
+        } else {
+            cfg->send_window = SEND_WINDOW_DEFAULT;
+        }
+    }
+
+    return 0;
 }
 
 static int config_check_payload_file(struct config *cfg, char **payload, char *buf, int len)
@@ -2316,6 +2721,14 @@ static int config_check_payload_file(struct config *cfg, char **payload, char *b
         return -1;
     }
 
+    /* a tcp server replays a large file as it is */
+    if ((cfg->protocol == IPPROTO_TCP) && cfg->server && (size > cfg->mss)) {
+        cfg->payload_object = true;
+        config_set_payload_size(cfg, size);
+        *payload = buf;
+        return 0;
+    }
+
     if (size > config_packet_payload_size(cfg)) {
         printf("Error: large 'payload_size', please use 'jumbo' to increase the MTU.\n");
         return -1;
@@ -2411,7 +2824,14 @@ static int config_check_payload(struct config *cfg)
             printf("Error: 'payload_size' is inconsistent.\n");
             return -1;
         }
-        http_set_payload(cfg, payload);
+
+        /* the data of an object is attached to the template of a full segment */
+        if (cfg->payload_object) {
+            payload = NULL;
+        }
+        if (http_set_payload(cfg, payload) < 0) {
+            return -1;
+        }
     } else {
         udp_set_payload(cfg, payload);
     }
@@ -2441,8 +2861,15 @@ static int config_check_mss(struct config *cfg)
         return -1;
     }
 
+    if (cfg->timestamps) {
+        mss_max -= TCPOLEN_TSTAMP_APPA;
+    }
+
     if (cfg->mss == 0) {
         cfg->mss = mss_max;
+    } else if (cfg->mss > mss_max) {
+        /* every segment carries the timestamps option */
+        cfg->mss = mss_max;
     }
 
     return 0;
@@ -2533,19 +2960,32 @@ static int config_check_keepalive(struct config *cfg)
     return 0;
 }
 
+/*
+ * http pipelining: a client sends 'pipeline' requests back to back in one segment,
+ * a server answers all requests of a segment in its send window.
+ * */
+static int config_check_pipeline_http(struct config *cfg)
+{
+    if (cfg->http == false) {
+        printf("Error: \'pipeline\' of tcp requires \'protocol http\'\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 static int config_check_pipeline(struct config *cfg)
 {
     if (cfg->pipeline == 0) {
         return 0;
     }
 
-    if (cfg->server) {
-        printf("Error: \'pipeline\' cannot set in server mode\n");
-        return -1;
+    if (cfg->protocol == IPPROTO_TCP) {
+        return config_check_pipeline_http(cfg);
     }
 
-    if (cfg->protocol == IPPROTO_TCP) {
-        printf("Error: \'pipeline\' cannot support tcp\n");
+    if (cfg->server) {
+        printf("Error: \'pipeline\' cannot set in server mode\n");
         return -1;
     }
 
@@ -2697,6 +3137,295 @@ static int config_check_flow_isolate(struct config *cfg)
     return 0;
 }
 
+static int config_check_socket_table(struct config *cfg)
+{
+    if (cfg->socket_table == 0) {
+        cfg->socket_table = SOCKET_TABLE_DENSE;
+    }
+
+    /* clients pick sockets in order, so every socket is touched anyway */
+    if ((cfg->socket_table == SOCKET_TABLE_SPARSE) && (!cfg->server)) {
+        printf("Error: 'socket_table sparse' is only supported in server mode\n");
+        return -1;
+    }
+
+    /* clients choose their own tuples, only servers see rewritten addresses */
+    if (cfg->socket_table == SOCKET_TABLE_HASH) {
+        if (!cfg->server) {
+            printf("Error: 'socket_table hash' is only supported in server mode\n");
+            return -1;
+        }
+
+        /* sockets keep the low 32 bits of addresses only */
+        if (cfg->af == AF_INET6) {
+            printf("Error: 'socket_table hash' does not support ipv6\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int config_check_adaptive_rto(struct config *cfg)
+{
+    /* udp has no acknowledgements to measure */
+    if (cfg->adaptive_rto && (cfg->protocol != IPPROTO_TCP)) {
+        printf("Error: 'adaptive_rto' is only supported by tcp\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int config_check_sack(struct config *cfg)
+{
+    if (cfg->sack && (cfg->protocol != IPPROTO_TCP)) {
+        printf("Error: 'sack' is only supported by tcp\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int config_check_congestion_control(struct config *cfg)
+{
+    if (cfg->tcp_cc == TCP_CC_NONE) {
+        if (cfg->send_window > SEND_WINDOW_MAX) {
+            printf("Error: 'send_window' larger than %d requires 'congestion_control'\n", SEND_WINDOW_MAX);
+            return -1;
+        }
+        return 0;
+    }
+
+    if ((cfg->protocol != IPPROTO_TCP) || (cfg->server == 0)) {
+        printf("Error: 'congestion_control' is only supported by tcp server\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int config_check_tso(struct config *cfg)
+{
+    if (cfg->tso == false) {
+        return 0;
+    }
+
+    if (cfg->protocol != IPPROTO_TCP) {
+        printf("Error: 'tso' is only supported by tcp\n");
+        return -1;
+    }
+
+    if (cfg->vxlan) {
+        printf("Error: 'tso' does not support vxlan\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* merged segments are only understood by the http client */
+static int config_check_gro(struct config *cfg)
+{
+    if (cfg->gro == false) {
+        return 0;
+    }
+
+    if (cfg->server || (cfg->http == false)) {
+        printf("Error: 'gro' is only supported by http client\n");
+        return -1;
+    }
+
+    if (cfg->vxlan) {
+        printf("Error: 'gro' does not support vxlan\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int config_check_ack_delay(struct config *cfg)
+{
+    if (cfg->ack_delay_us == 0) {
+        return 0;
+    }
+
+    if (cfg->protocol != IPPROTO_TCP) {
+        printf("Error: 'ack_delay' is only supported by tcp\n");
+        return -1;
+    }
+
+    if (cfg->disable_ack) {
+        printf("Error: 'ack_delay' conflicts with 'disable_ack'\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* the option is written into the headers after the checksum of vxlan templates */
+static int config_check_timestamps(struct config *cfg)
+{
+    if (cfg->timestamps == false) {
+        return 0;
+    }
+
+    if (cfg->protocol != IPPROTO_TCP) {
+        printf("Error: 'timestamps' is only supported by tcp\n");
+        return -1;
+    }
+
+    if (cfg->vxlan) {
+        printf("Error: 'timestamps' does not support vxlan\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* the header is written into the payload of each packet */
+static int config_check_udp_seq(struct config *cfg)
+{
+    int i = 0;
+
+    if (cfg->udp_seq == false) {
+        return 0;
+    }
+
+    if (cfg->protocol != IPPROTO_UDP) {
+        printf("Error: 'udp_seq' is only supported by udp\n");
+        return -1;
+    }
+
+    if (cfg->vxlan || cfg->tx_split) {
+        printf("Error: 'udp_seq' does not support vxlan or 'tx_split'\n");
+        return -1;
+    }
+
+    for (i = 0; i < cfg->cpu_num; i++) {
+        if (cfg->payload_size[i] < sizeof(struct udp_seq_hdr)) {
+            printf("Error: 'udp_seq' requires 'payload_size' %d or more\n", (int)sizeof(struct udp_seq_hdr));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* the queries of a client replace the payload */
+static int config_check_dns(struct config *cfg)
+{
+    if (cfg->dns == false) {
+        if (cfg->dns_names[0]) {
+            printf("Error: 'dns_names' requires 'dns'\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    if (cfg->protocol != IPPROTO_UDP) {
+        printf("Error: 'dns' is only supported by udp\n");
+        return -1;
+    }
+
+    if (cfg->vxlan_num || cfg->tx_split || cfg->udp_seq) {
+        printf("Error: 'dns' does not support vxlan, 'tx_split' or 'udp_seq'\n");
+        return -1;
+    }
+
+    if (cfg->server) {
+        if (cfg->dns_names[0]) {
+            printf("Error: 'dns_names' is only supported by client\n");
+            return -1;
+        }
+    } else {
+        if (cfg->dns_names[0] == 0) {
+            printf("Error: 'dns' client requires 'dns_names'\n");
+            return -1;
+        }
+
+        if (cfg->payload_size[0] || cfg->payload_path[0] || cfg->payload_random) {
+            printf("Error: 'dns' client cannot set the payload\n");
+            return -1;
+        }
+    }
+
+    if (dns_load(cfg) < 0) {
+        return -1;
+    }
+
+    if (!cfg->server) {
+        cfg->payload_size[0] = g_dns_names.query_max;
+    }
+
+    return 0;
+}
+
+/* the http client parses the queued segments in order */
+static int config_check_rx_reorder(struct config *cfg)
+{
+    if (cfg->rx_reorder == 0) {
+        return 0;
+    }
+
+    if ((cfg->protocol != IPPROTO_TCP) || cfg->server) {
+        printf("Error: 'rx_reorder' is only supported by tcp client\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* established sockets are created in the hash socket table */
+static int config_check_syn_cookie(struct config *cfg)
+{
+    if (cfg->syn_cookie == false) {
+        return 0;
+    }
+
+    if ((cfg->protocol != IPPROTO_TCP) || (!cfg->server)) {
+        printf("Error: 'syn_cookie' is only supported by tcp server\n");
+        return -1;
+    }
+
+    if (cfg->socket_table != SOCKET_TABLE_HASH) {
+        printf("Error: 'syn_cookie' requires 'socket_table hash'\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* the inner checksums of vxlan are computed from linear templates */
+static int config_check_tx_split(struct config *cfg)
+{
+    if (cfg->tx_split == false) {
+        return 0;
+    }
+
+    if (cfg->vxlan) {
+        printf("Error: 'tx_split' does not support vxlan\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* data segments of an object are built from the headers of a non-vxlan template */
+static int config_check_payload_object(struct config *cfg)
+{
+    if (cfg->payload_object == false) {
+        return 0;
+    }
+
+    if (cfg->vxlan || cfg->pipeline) {
+        printf("Error: large 'payload_file' does not support vxlan or 'pipeline'\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 int config_parse(int argc, char **argv, struct config *cfg)
 {
     int conf = 0;
@@ -2804,6 +3533,10 @@ int config_parse(int argc, char **argv, struct config *cfg)
         return -1;
     }
 
+    if (config_check_dns(cfg) < 0) {
+        return -1;
+    }
+
     if (config_check_payload(cfg) < 0) {
         return -1;
     }
@@ -2858,6 +3591,58 @@ int config_parse(int argc, char **argv, struct config *cfg)
         return -1;
     }
 
+    if (config_check_socket_table(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_adaptive_rto(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_sack(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_congestion_control(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_tso(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_gro(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_payload_object(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_tx_split(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_ack_delay(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_timestamps(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_syn_cookie(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_rx_reorder(cfg) < 0) {
+        return -1;
+    }
+
+    if (config_check_udp_seq(cfg) < 0) {
+        return -1;
+    }
+
     if (test) {
         printf("Config file OK\n");
         exit(0);
@@ -2882,6 +3667,10 @@ uint32_t config_get_total_socket_num(struct config *cfg, int id)
     struct ip_range *client_ip_range = NULL;
     struct netif_port *port = NULL;
 
+    if (cfg->socket_table == SOCKET_TABLE_HASH) {
+        return cfg->socket_hash_num;
+    }
+
     port = config_port_get(cfg, id, NULL);
     if (cfg->server) {
         /*
@@ -2920,4 +3709,14 @@ void config_set_tsc(struct config *cfg, uint64_t hz)
 
     cfg->keepalive_request_interval = tsc;
     cfg->retransmit_timeout = hz * cfg->retransmit_timeout_sec;
+
+    /* by default, delayed acks are sent on the next tick */
+    if (cfg->ack_delay_us) {
+        cfg->ack_delay = (cfg->ack_delay_us * (hz / 1000)) / 1000;
+    } else if (cfg->ticks_per_sec) {
+        cfg->ack_delay = hz / cfg->ticks_per_sec;
+    } else {
+        cfg->ack_delay = hz / TICKS_PER_SEC_DEFAULT;
+    }
+    cfg->rto_min = (hz / 1000) * cfg->rto_min_ms;
 }
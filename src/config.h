@@ -76,6 +76,8 @@
 #define SEND_WINDOW_MAX     16
 #define SEND_WINDOW_MIN     2
 #define SEND_WINDOW_DEFAULT 4
+/* with congestion_control, send_window only clamps the congestion window */
+#define SEND_WINDOW_CC_MAX  255
 
 #define HTTP_HOST_DEFAULT   "dperf"
 #define HTTP_PATH_DEFAULT   "/"
@@ -83,7 +85,20 @@
 #define HTTP_METH_GET       0
 #define HTTP_METH_POST      1
 
-#define TCP_ACK_DELAY_MAX   1024
+#define TCP_ACK_DELAY_MAX   16384   /* power of 2, delayed acks per worker */
+#define TCP_ACK_DELAY_MASK  (TCP_ACK_DELAY_MAX - 1)
+#define ACK_DELAY_US_MAX    (500 * 1000)
+#define ACK_DELAY_SEGS_DEFAULT  2
+#define ACK_DELAY_SEGS_MAX  64
+
+/* rx_reorder: segments per socket, buffers per worker */
+#define TCP_REORDER_DEPTH_MAX   16
+#define TCP_REORDER_NUM_DEFAULT 1024
+#define TCP_REORDER_NUM_MAX     65535
+
+/* dns: A records of a response, generated or listed qnames */
+#define DNS_ANSWERS_MAX     32
+#define DNS_NAME_NUM_MAX    (1 << 24)
 
 #define KNI_NAMESIZE        10
 
@@ -104,11 +119,21 @@
 #define RTO_DEFAULT         2
 #define RTO_MIN             2
 #define RTO_MAX             300
+/* adaptive rto, milliseconds */
+#define RTO_MIN_MS_DEFAULT  200
+#define RTO_MIN_MS_MAX      (RTO_MIN * 1000)
 
 #define FLOW_NONE   0
 #define FLOW_FDIR   1
 #define FLOW_RSS    2
 
+#define SOCKET_TABLE_DENSE  1
+#define SOCKET_TABLE_SPARSE 2
+#define SOCKET_TABLE_HASH   3
+
+#define SOCKET_HASH_NUM_DEFAULT (1024 * 1024)
+#define SOCKET_HASH_NUM_MAX     (64 * 1024 * 1024)
+
 struct config {
     bool server;
     bool keepalive;
@@ -126,8 +151,17 @@ struct config {
     bool disable_ack;
     uint8_t log_level;
     uint8_t flow;
+    uint8_t socket_table;
     bool quiet;
     bool tcp_rst;
+    bool sack;
+    bool tso;
+    bool gro;
+    bool tx_split;  /* headers and payload of a data packet in two mbufs */
+    bool timestamps;
+    bool syn_cookie;
+    bool udp_seq;
+    bool dns;
     bool neigh_ignore;
     bool flow_isolate;
     bool http;
@@ -137,6 +171,7 @@ struct config {
     uint8_t pipeline;
     uint8_t tx_burst;
     uint8_t send_window;/* packets */
+    uint8_t tcp_cc;     /* TCP_CC_NONE/... see tcp_cc.h */
     uint8_t protocol;   /* TCP/UDP */
     uint16_t vlan_id;
     uint16_t jumbo_mtu;
@@ -152,6 +187,16 @@ struct config {
     uint32_t retransmit_timeout_sec;
     /* tsc */
     uint64_t retransmit_timeout;
+    bool adaptive_rto;
+    uint32_t rto_min_ms;
+    /* tsc */
+    uint64_t rto_min;
+    uint32_t ack_delay_us;
+    uint8_t ack_delay_segs;
+    uint8_t rx_reorder;         /* depth */
+    uint16_t rx_reorder_num;    /* buffers per worker */
+    /* tsc */
+    uint64_t ack_delay;
     uint64_t keepalive_request_interval_us;
     /* tsc */
     uint64_t keepalive_request_interval;
@@ -161,6 +206,10 @@ struct config {
     char http_path[HTTP_PATH_MAX];
 
     char payload_path[PAYLOAD_PATH_MAX];
+    char dns_names[PAYLOAD_PATH_MAX];   /* a domain, or a file if dns_name_num is 0 */
+    uint32_t dns_name_num;
+    uint8_t dns_answers;
+    bool payload_object; /* the payload_file is sent as a whole response, see payload.h */
     uint32_t payload_size[THREAD_NUM_MAX];
     int mss;
 
@@ -170,6 +219,7 @@ struct config {
     int duration;
     int cps;        /* connection per seconds */
     int cc;         /* current connections */
+    uint32_t socket_hash_num; /* sockets per worker of the hash socket table */
 
     int cpu[THREAD_NUM_MAX];
     int cpu_num;
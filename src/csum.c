@@ -132,14 +132,26 @@ static void csum_inner_tcp_udp_ipv4(struct socket *sk, struct mbuf_cache *mcache
     th->th_dport = 0;
 }
 
+/* the inner ip checksum of a template, with zero addresses and ip id */
+uint16_t csum_inner_ip_template(struct mbuf_cache *mcache)
+{
+    struct iphdr *iph = NULL;
+
+    iph = (struct iphdr *)((uint8_t*)(mcache->data.data) + VXLAN_HEADERS_SIZE + sizeof(struct eth_hdr));
+    return RTE_IPV4_CKSUM(iph);
+}
+
 static void csum_init_inner_ipv4(struct work_space *ws, struct socket *sk)
 {
+    uint16_t ip_csum = 0;
+
     if (ws->cfg->protocol == IPPROTO_TCP) {
         csum_inner_tcp_udp_ipv4(sk, &ws->tcp, &sk->csum_ip, &sk->csum_tcp);
         csum_inner_tcp_udp_ipv4(sk, &ws->tcp_opt, &sk->csum_ip_opt, &sk->csum_tcp_opt);
         csum_inner_tcp_udp_ipv4(sk, &ws->tcp_data, &sk->csum_ip_data, &sk->csum_tcp_data);
     } else {
-        csum_inner_tcp_udp_ipv4(sk, &ws->udp, &sk->csum_ip, &sk->csum_udp);
+        /* see udp_new_packet() */
+        csum_inner_tcp_udp_ipv4(sk, &ws->udp, &ip_csum, &sk->csum_udp);
     }
 }
 
@@ -130,7 +130,9 @@ static inline void csum_offload_ip_tcpudp(struct rte_mbuf *m, uint64_t ol_flags)
 
 struct work_space;
 struct socket;
+struct mbuf_cache;
 void csum_init_socket(struct work_space *ws, struct socket *sk);
+uint16_t csum_inner_ip_template(struct mbuf_cache *mcache);
 int csum_check(struct rte_mbuf *m);
 
 #endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "dns.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "config.h"
+
+#define DNS_LINE_SIZE   1024
+
+struct dns_names g_dns_names;
+uint8_t g_dns_answers[DNS_ANSWERS_MAX * DNS_ANSWER_SIZE];
+
+/* "www.example.com" to "\3www\7example\3com\0", and return the length */
+static int dns_name_encode(const char *name, uint8_t *buf)
+{
+    int len = 0;
+    size_t label = 0;
+    const char *p = name;
+    const char *dot = NULL;
+
+    while (*p) {
+        dot = strchr(p, '.');
+        if (dot) {
+            label = dot - p;
+        } else {
+            label = strlen(p);
+        }
+
+        if ((label == 0) || (label > DNS_LABEL_MAX) || (len + 1 + label + 1 > DNS_NAME_MAX)) {
+            return -1;
+        }
+
+        buf[len++] = label;
+        memcpy(buf + len, p, label);
+        len += label;
+        if (dot == NULL) {
+            break;
+        }
+        p = dot + 1;
+    }
+
+    if (len == 0) {
+        return -1;
+    }
+    buf[len++] = 0;
+
+    return len;
+}
+
+static int dns_names_add(struct dns_names *names, uint32_t *num_max, uint32_t *size, const char *name)
+{
+    int len = 0;
+    uint32_t offset = 0;
+    void *p = NULL;
+    uint8_t buf[DNS_NAME_MAX];
+
+    if ((len = dns_name_encode(name, buf)) < 0) {
+        printf("Error: bad dns name: %s\n", name);
+        return -1;
+    }
+
+    if (names->num >= DNS_NAME_NUM_MAX) {
+        printf("Error: more than %d dns names\n", DNS_NAME_NUM_MAX);
+        return -1;
+    }
+
+    /* offset[num] is the end of the last name */
+    if (names->num + 2 > *num_max) {
+        *num_max = (*num_max + 2) * 2;
+        if ((p = realloc(names->offset, *num_max * sizeof(uint32_t))) == NULL) {
+            goto err;
+        }
+        names->offset = p;
+    }
+
+    offset = names->offset[names->num];
+    if (offset + len > *size) {
+        *size = (*size + len) * 2;
+        if ((p = realloc(names->data, *size)) == NULL) {
+            goto err;
+        }
+        names->data = p;
+    }
+
+    memcpy(names->data + offset, buf, len);
+    names->num++;
+    names->offset[names->num] = offset + len;
+    if (sizeof(struct dns_hdr) + len + DNS_QTAIL_SIZE > names->query_max) {
+        names->query_max = sizeof(struct dns_hdr) + len + DNS_QTAIL_SIZE;
+    }
+
+    return 0;
+
+err:
+    printf("Error: no memory for dns names\n");
+    return -1;
+}
+
+static int dns_names_init(struct dns_names *names, uint32_t *num_max)
+{
+    *num_max = 2;
+    names->offset = calloc(*num_max, sizeof(uint32_t));
+    if (names->offset == NULL) {
+        printf("Error: no memory for dns names\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* "0.Domain", "1.Domain", ... */
+static int dns_names_generate(struct dns_names *names, const char *domain, uint32_t num)
+{
+    uint32_t i = 0;
+    uint32_t size = 0;
+    uint32_t num_max = 0;
+    char name[DNS_LINE_SIZE];
+
+    if (dns_names_init(names, &num_max) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < num; i++) {
+        snprintf(name, DNS_LINE_SIZE, "%u.%s", i, domain);
+        if (dns_names_add(names, &num_max, &size, name) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* one name per line, '#' starts a comment */
+static int dns_names_read(struct dns_names *names, const char *path)
+{
+    int ret = -1;
+    FILE *fp = NULL;
+    char *p = NULL;
+    char *end = NULL;
+    uint32_t size = 0;
+    uint32_t num_max = 0;
+    char line[DNS_LINE_SIZE];
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("Error: cannot open file: %s\n", path);
+        return -1;
+    }
+
+    if (dns_names_init(names, &num_max) < 0) {
+        goto out;
+    }
+
+    while (fgets(line, DNS_LINE_SIZE, fp) != NULL) {
+        p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+
+        end = p;
+        while ((*end) && (*end != '#') && (!isspace((unsigned char)*end))) {
+            end++;
+        }
+        *end = 0;
+
+        if ((*p) && (dns_names_add(names, &num_max, &size, p) < 0)) {
+            goto out;
+        }
+    }
+
+    if (names->num == 0) {
+        printf("Error: no dns names in %s\n", path);
+        goto out;
+    }
+    ret = 0;
+
+out:
+    fclose(fp);
+    return ret;
+}
+
+/* A records of 192.0.2.0/24 (TEST-NET-1), the owner is the question at offset 12 */
+static void dns_answers_init(void)
+{
+    int i = 0;
+    uint8_t *p = NULL;
+
+    for (i = 0; i < DNS_ANSWERS_MAX; i++) {
+        p = g_dns_answers + i * DNS_ANSWER_SIZE;
+        p[0] = 0xc0;
+        p[1] = sizeof(struct dns_hdr);
+        p[2] = 0;
+        p[3] = DNS_TYPE_A;
+        p[4] = 0;
+        p[5] = DNS_CLASS_IN;
+        *(uint32_t *)(p + 6) = htonl(DNS_TTL);
+        p[10] = 0;
+        p[11] = 4;
+        p[12] = 192;
+        p[13] = 0;
+        p[14] = 2;
+        p[15] = i + 1;
+    }
+}
+
+int dns_load(struct config *cfg)
+{
+    if (!cfg->dns) {
+        return 0;
+    }
+
+    dns_answers_init();
+    if (cfg->server) {
+        return 0;
+    }
+
+    if (cfg->dns_name_num) {
+        return dns_names_generate(&g_dns_names, cfg->dns_names, cfg->dns_name_num);
+    }
+
+    return dns_names_read(&g_dns_names, cfg->dns_names);
+}
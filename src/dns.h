@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __DNS_H
+#define __DNS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <rte_branch_prediction.h>
+
+#define DNS_FLAG_QR         0x8000
+#define DNS_FLAG_OPCODE     0x7800
+#define DNS_FLAG_AA         0x0400
+#define DNS_FLAG_RD         0x0100
+
+#define DNS_TYPE_A          1
+#define DNS_CLASS_IN        1
+#define DNS_TTL             3600
+
+#define DNS_LABEL_MAX       63
+#define DNS_NAME_MAX        255     /* wire format, with the root label */
+#define DNS_QTAIL_SIZE      4       /* qtype, qclass */
+#define DNS_ANSWER_SIZE     16      /* compressed name, type A */
+
+struct dns_hdr {
+    uint16_t id;
+    uint16_t flags;
+    uint16_t qdcount;
+    uint16_t ancount;
+    uint16_t nscount;
+    uint16_t arcount;
+} __attribute__((__packed__));
+
+/*
+ * The qnames of a client in wire format, loaded before the workers start.
+ * The name i is data[offset[i]...offset[i + 1]).
+ * */
+struct dns_names {
+    uint8_t *data;
+    uint32_t *offset;
+    uint32_t num;
+    uint16_t query_max;     /* the dns payload of the longest name */
+};
+
+extern struct dns_names g_dns_names;
+extern uint8_t g_dns_answers[];
+
+struct config;
+int dns_load(struct config *cfg);
+
+/* write the query of name 'idx', and return its length */
+static inline uint16_t dns_query_write(uint8_t *data, uint16_t id, uint32_t idx)
+{
+    struct dns_hdr *hdr = (struct dns_hdr *)data;
+    uint8_t *p = data + sizeof(struct dns_hdr);
+    uint32_t offset = g_dns_names.offset[idx];
+    uint16_t name_len = g_dns_names.offset[idx + 1] - offset;
+
+    hdr->id = htons(id);
+    hdr->flags = htons(DNS_FLAG_RD);
+    hdr->qdcount = htons(1);
+    hdr->ancount = 0;
+    hdr->nscount = 0;
+    hdr->arcount = 0;
+
+    memcpy(p, g_dns_names.data + offset, name_len);
+    p += name_len;
+    p[0] = 0;
+    p[1] = DNS_TYPE_A;
+    p[2] = 0;
+    p[3] = DNS_CLASS_IN;
+
+    return sizeof(struct dns_hdr) + name_len + DNS_QTAIL_SIZE;
+}
+
+/*
+ * Turn the query of 'len' bytes into its response in place, and return the length
+ * of the response, or 0 if it is not a query. The id and the question are kept,
+ * additional records (EDNS) are dropped, and a query of type A gets 'answers'
+ * records. 'room' is the size of the buffer.
+ * */
+static inline uint16_t dns_reply(uint8_t *data, uint16_t len, uint16_t room, int answers)
+{
+    struct dns_hdr *hdr = (struct dns_hdr *)data;
+    uint8_t *p = data + sizeof(struct dns_hdr);
+    uint8_t *end = data + len;
+    uint16_t qlen = 0;
+    uint16_t an_len = 0;
+
+    if (unlikely(len < sizeof(struct dns_hdr) + 1 + DNS_QTAIL_SIZE)) {
+        return 0;
+    }
+
+    if (unlikely((hdr->flags & htons(DNS_FLAG_QR | DNS_FLAG_OPCODE)) || (hdr->qdcount != htons(1)))) {
+        return 0;
+    }
+
+    /* a question has no compression pointers */
+    while (*p) {
+        if (unlikely(*p > DNS_LABEL_MAX)) {
+            return 0;
+        }
+        p += *p + 1;
+        if (unlikely(p + 1 + DNS_QTAIL_SIZE > end)) {
+            return 0;
+        }
+    }
+    p++;
+
+    if ((p[0] == 0) && (p[1] == DNS_TYPE_A) && (p[2] == 0) && (p[3] == DNS_CLASS_IN)) {
+        an_len = answers * DNS_ANSWER_SIZE;
+    } else {
+        answers = 0;
+    }
+    p += DNS_QTAIL_SIZE;
+
+    qlen = p - data;
+    if (unlikely(qlen + an_len > room)) {
+        return 0;
+    }
+
+    hdr->flags = htons(DNS_FLAG_QR | DNS_FLAG_AA) | (hdr->flags & htons(DNS_FLAG_RD));
+    hdr->ancount = htons(answers);
+    hdr->nscount = 0;
+    hdr->arcount = 0;
+    memcpy(p, g_dns_answers, an_len);
+
+    return qlen + an_len;
+}
+
+#endif
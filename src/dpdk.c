@@ -38,6 +38,8 @@
 #include "flow.h"
 #include "tick.h"
 #include "kni.h"
+#include "payload.h"
+#include "http_parse.h"
 #include "rss.h"
 
 static void dpdk_set_lcores(struct config *cfg, char *lcores)
@@ -170,6 +172,15 @@ int dpdk_init(struct config *cfg, char *argv0)
         return -1;
     }
 
+    if (payload_object_load(cfg) < 0) {
+        printf("payload object load fail\n");
+        return -1;
+    }
+
+#ifdef HTTP_PARSE
+    http_parse_init();
+#endif
+
     /* One-way traffic does not require RSS and FDIR */
     if (cfg->flow == FLOW_FDIR) {
         if (flow_init(cfg) < 0) {
@@ -30,8 +30,11 @@
 #define RTE_ETH_TX_OFFLOAD_IPV4_CKSUM   DEV_TX_OFFLOAD_IPV4_CKSUM
 #define RTE_ETH_TX_OFFLOAD_TCP_CKSUM    DEV_TX_OFFLOAD_TCP_CKSUM
 #define RTE_ETH_TX_OFFLOAD_UDP_CKSUM    DEV_TX_OFFLOAD_UDP_CKSUM
+#define RTE_ETH_TX_OFFLOAD_TCP_TSO      DEV_TX_OFFLOAD_TCP_TSO
+#define RTE_ETH_TX_OFFLOAD_MULTI_SEGS   DEV_TX_OFFLOAD_MULTI_SEGS
 #define RTE_ETH_TX_OFFLOAD_VLAN_INSERT  DEV_TX_OFFLOAD_VLAN_INSERT
 #define RTE_ETH_RX_OFFLOAD_VLAN_STRIP   DEV_RX_OFFLOAD_VLAN_STRIP
+#define RTE_ETH_RX_OFFLOAD_TCP_LRO      DEV_RX_OFFLOAD_TCP_LRO
 
 #define RTE_ETH_RSS_IPV4                ETH_RSS_IPV4
 #define RTE_ETH_RSS_FRAG_IPV4           ETH_RSS_FRAG_IPV4
@@ -54,6 +57,7 @@
 #define RTE_MBUF_F_TX_IPV4          PKT_TX_IPV4
 #define RTE_MBUF_F_TX_TCP_CKSUM     PKT_TX_TCP_CKSUM
 #define RTE_MBUF_F_TX_UDP_CKSUM     PKT_TX_UDP_CKSUM
+#define RTE_MBUF_F_TX_TCP_SEG       PKT_TX_TCP_SEG
 #endif
 
 #if RTE_VERSION >= RTE_VERSION_NUM(19, 0, 0, 0)
@@ -72,10 +76,14 @@
 #define RTE_IPV4_CKSUM(iph) rte_ipv4_cksum((struct ipv4_hdr*)iph)
 #define RTE_IPV4_UDPTCP_CKSUM(iph, th) rte_ipv4_udptcp_cksum((const struct ipv4_hdr *)iph, th)
 #define RTE_IPV6_UDPTCP_CKSUM(iph, th) rte_ipv6_udptcp_cksum((const struct ipv6_hdr *)iph, (const void *)th)
+#define RTE_IPV4_PHDR_CKSUM(iph, ol_flags) rte_ipv4_phdr_cksum((const struct ipv4_hdr *)iph, ol_flags)
+#define RTE_IPV6_PHDR_CKSUM(iph, ol_flags) rte_ipv6_phdr_cksum((const struct ipv6_hdr *)iph, ol_flags)
 #else
 #define RTE_IPV4_CKSUM(iph) rte_ipv4_cksum((const struct rte_ipv4_hdr *)iph)
 #define RTE_IPV4_UDPTCP_CKSUM(iph, th) rte_ipv4_udptcp_cksum((const struct rte_ipv4_hdr *)iph, th)
 #define RTE_IPV6_UDPTCP_CKSUM(iph, th) rte_ipv6_udptcp_cksum((const struct rte_ipv6_hdr *)iph, (const void *)th)
+#define RTE_IPV4_PHDR_CKSUM(iph, ol_flags) rte_ipv4_phdr_cksum((const struct rte_ipv4_hdr *)iph, ol_flags)
+#define RTE_IPV6_PHDR_CKSUM(iph, ol_flags) rte_ipv6_phdr_cksum((const struct rte_ipv6_hdr *)iph, ol_flags)
 #endif
 
 #if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
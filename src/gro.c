@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "gro.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <rte_ip_frag.h>
+
+#include "dpdk.h"
+#include "eth.h"
+#include "mbuf.h"
+#include "net_stats.h"
+#include "tcp.h"
+#include "work_space.h"
+
+struct gro_flow {
+    struct rte_mbuf *m;
+    uint32_t seq;       /* next expected */
+    uint32_t ack;
+    uint32_t ip_len;
+};
+
+struct gro_pkt {
+    struct tcphdr *th;
+    uint16_t hdr_len;   /* l2 + l3 + l4 */
+    uint16_t data_len;
+    uint32_t ip_len;
+    bool data;          /* can be merged */
+};
+
+/* return false if it is not tcp */
+static bool gro_parse(struct rte_mbuf *m, struct gro_pkt *pkt)
+{
+    struct eth_hdr *eth = mbuf_eth_hdr(m);
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+    uint16_t l3_len = 0;
+
+    if (eth->type == htons(ETHER_TYPE_IPv4)) {
+        if ((iph->protocol != IPPROTO_TCP) || (iph->ihl != 5)) {
+            return false;
+        }
+        l3_len = sizeof(struct iphdr);
+        pkt->ip_len = ntohs(iph->tot_len);
+        pkt->data = !rte_ipv4_frag_pkt_is_fragmented((const struct rte_ipv4_hdr *)iph);
+    } else if (eth->type == htons(ETHER_TYPE_IPv6)) {
+        if (ip6h->ip6_nxt != IPPROTO_TCP) {
+            return false;
+        }
+        l3_len = sizeof(struct ip6_hdr);
+        pkt->ip_len = ntohs(ip6h->ip6_plen) + l3_len;
+        pkt->data = true;
+    } else {
+        return false;
+    }
+
+    pkt->th = (struct tcphdr *)((uint8_t *)iph + l3_len);
+    pkt->hdr_len = sizeof(struct eth_hdr) + l3_len + pkt->th->th_off * 4;
+    pkt->data_len = pkt->ip_len + sizeof(struct eth_hdr) - pkt->hdr_len;
+
+    /* plain data segments only, the others are processed one by one */
+    if ((pkt->th->th_off != 5) || ((pkt->th->th_flags & ~TH_PUSH) != TH_ACK) ||
+        (pkt->data_len == 0) || (pkt->data_len > pkt->ip_len) || (m->nb_segs != 1) ||
+        (m->ol_flags & (RTE_MBUF_F_RX_IP_CKSUM_BAD | RTE_MBUF_F_RX_L4_CKSUM_BAD)) ||
+        (rte_pktmbuf_pkt_len(m) < (pkt->ip_len + sizeof(struct eth_hdr)))) {
+        pkt->data = false;
+    }
+
+    return true;
+}
+
+static bool gro_same_flow(struct rte_mbuf *m0, struct tcphdr *th0, struct rte_mbuf *m1, struct tcphdr *th1)
+{
+    struct iphdr *iph0 = mbuf_ip_hdr(m0);
+    struct iphdr *iph1 = mbuf_ip_hdr(m1);
+    struct ip6_hdr *ip6h0 = (struct ip6_hdr *)iph0;
+    struct ip6_hdr *ip6h1 = (struct ip6_hdr *)iph1;
+
+    if ((th0->th_sport != th1->th_sport) || (th0->th_dport != th1->th_dport) || (iph0->version != iph1->version)) {
+        return false;
+    }
+
+    if (iph0->version == 4) {
+        return (iph0->saddr == iph1->saddr) && (iph0->daddr == iph1->daddr);
+    }
+
+    return memcmp(&ip6h0->ip6_src, &ip6h1->ip6_src, sizeof(struct in6_addr) * 2) == 0;
+}
+
+static void gro_flow_open(struct gro_flow *flow, struct rte_mbuf *m, struct gro_pkt *pkt)
+{
+    /* remove the ethernet padding before data is appended */
+    rte_pktmbuf_trim(m, rte_pktmbuf_pkt_len(m) - pkt->ip_len - sizeof(struct eth_hdr));
+    flow->m = m;
+    flow->seq = ntohl(pkt->th->th_seq) + pkt->data_len;
+    flow->ack = pkt->th->th_ack;
+    flow->ip_len = pkt->ip_len;
+}
+
+static bool gro_flow_append(struct gro_flow *flow, struct rte_mbuf *m, struct gro_pkt *pkt)
+{
+    struct rte_mbuf *head = flow->m;
+    struct iphdr *iph = mbuf_ip_hdr(head);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+
+    if ((ntohl(pkt->th->th_seq) != flow->seq) || (pkt->th->th_ack != flow->ack) ||
+        (head->nb_segs >= GRO_SEG_MAX) || ((flow->ip_len + pkt->data_len) > 0xffff)) {
+        return false;
+    }
+
+    /* this segment is not seen by l3 input */
+    net_stats_rx(m);
+    net_stats_tcp_rx();
+
+    rte_pktmbuf_trim(m, rte_pktmbuf_pkt_len(m) - pkt->ip_len - sizeof(struct eth_hdr));
+    rte_pktmbuf_adj(m, pkt->hdr_len);
+    if (rte_pktmbuf_chain(head, m) < 0) {
+        /* never happens, nb_segs is checked */
+        rte_pktmbuf_free(m);
+        return true;
+    }
+
+    flow->seq += pkt->data_len;
+    flow->ip_len += pkt->data_len;
+    if (iph->version == 4) {
+        iph->tot_len = htons(flow->ip_len);
+    } else {
+        ip6h->ip6_plen = htons(flow->ip_len - sizeof(struct ip6_hdr));
+    }
+    mbuf_tcp_hdr(head)->th_flags |= pkt->th->th_flags;
+
+    return true;
+}
+
+int gro_merge(__rte_unused struct work_space *ws, struct rte_mbuf **mbufs, int num)
+{
+    int i = 0;
+    int j = 0;
+    int out = 0;
+    int flow_num = 0;
+    struct rte_mbuf *m = NULL;
+    struct gro_flow *flow = NULL;
+    struct gro_pkt pkt;
+    struct gro_flow flows[GRO_FLOW_MAX];
+
+    for (i = 0; i < num; i++) {
+        m = mbufs[i];
+        if (!gro_parse(m, &pkt)) {
+            mbufs[out++] = m;
+            continue;
+        }
+
+        flow = NULL;
+        for (j = 0; j < flow_num; j++) {
+            if (gro_same_flow(flows[j].m, mbuf_tcp_hdr(flows[j].m), m, pkt.th)) {
+                flow = &flows[j];
+                break;
+            }
+        }
+
+        if (pkt.data) {
+            if ((flow != NULL) && gro_flow_append(flow, m, &pkt)) {
+                continue;
+            }
+
+            if (flow == NULL) {
+                if (flow_num >= GRO_FLOW_MAX) {
+                    mbufs[out++] = m;
+                    continue;
+                }
+                flow = &flows[flow_num++];
+            }
+            gro_flow_open(flow, m, &pkt);
+        } else if (flow != NULL) {
+            /* keep the order: nothing behind a fin/rst/... is merged into the flow */
+            *flow = flows[--flow_num];
+        }
+
+        mbufs[out++] = m;
+    }
+
+    return out;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __GRO_H
+#define __GRO_H
+
+#include <rte_mbuf.h>
+
+/*
+ * Software GRO of a rx burst: in-order tcp data segments of the same flow are chained
+ * to the first one, which then carries the total length in its ip header.
+ * */
+#define GRO_FLOW_MAX    8
+#define GRO_SEG_MAX     32
+
+struct work_space;
+int gro_merge(struct work_space *ws, struct rte_mbuf **mbufs, int num);
+
+#endif
@@ -136,7 +136,26 @@ static void http_set_payload_server(struct config *cfg, char *dest, int len, int
 #pragma GCC diagnostic pop
 }
 
-void http_set_payload(struct config *cfg, char *payload)
+/* pipeline: the requests of a client are sent back to back in one segment */
+static int http_set_pipeline(struct config *cfg, char *dest, int len)
+{
+    int i = 0;
+    int size = strlen(dest);
+
+    if ((size * cfg->pipeline > cfg->mss) || (size * cfg->pipeline >= len)) {
+        printf("Error: %d pipelined requests are larger than mss %d\n", cfg->pipeline, cfg->mss);
+        return -1;
+    }
+
+    for (i = 1; i < cfg->pipeline; i++) {
+        memcpy(dest + size * i, dest, size);
+    }
+    dest[size * cfg->pipeline] = 0;
+
+    return 0;
+}
+
+int http_set_payload(struct config *cfg, char *payload)
 {
     int i = 0;
 
@@ -154,5 +173,13 @@ void http_set_payload(struct config *cfg, char *payload)
                 http_set_payload_client(cfg, http_req[i], MBUF_DATA_SIZE, cfg->payload_size[i]);
             }
         }
+
+        if ((cfg->server == 0) && (cfg->pipeline > 1)) {
+            if (http_set_pipeline(cfg, http_req[i], MBUF_DATA_SIZE) < 0) {
+                return -1;
+            }
+        }
     }
+
+    return 0;
 }
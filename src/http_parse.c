@@ -21,10 +21,110 @@
 #include "mbuf.h"
 #include "http.h"
 #include <stdlib.h>
+#include <rte_cpuflags.h>
+#include <rte_version.h>
 
 #ifdef HTTP_PARSE
 #define STRING_SIZE(str)  (sizeof(str) - 1)
 
+/*
+ * Return the first '\n' in [p, end), or 'end'. If 'colon' points to NULL, it is set to
+ * the first ':' before the '\n'.
+ * */
+typedef const uint8_t *(*http_scan_line_t)(const uint8_t *p, const uint8_t *end, const uint8_t **colon);
+
+static const uint8_t *http_scan_line_scalar(const uint8_t *p, const uint8_t *end, const uint8_t **colon)
+{
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            break;
+        } else if ((*p == ':') && colon && (*colon == NULL)) {
+            *colon = p;
+        }
+    }
+
+    return p;
+}
+
+#ifdef __SSE2__
+/* the colons before the lowest '\n' of a block */
+static inline void http_scan_colon(const uint8_t *p, uint32_t lf, uint32_t cl, const uint8_t **colon)
+{
+    if (lf) {
+        cl &= lf - 1;
+    }
+
+    if (cl) {
+        *colon = p + __builtin_ctz(cl);
+    }
+}
+
+static const uint8_t *http_scan_line_sse(const uint8_t *p, const uint8_t *end, const uint8_t **colon)
+{
+    __m128i v;
+    uint32_t lf = 0;
+    uint32_t cl = 0;
+    const __m128i lf_key = _mm_set1_epi8('\n');
+    const __m128i cl_key = _mm_set1_epi8(':');
+
+    while (end - p >= 16) {
+        v = _mm_loadu_si128((const __m128i *)p);
+        lf = _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf_key));
+        if (colon && (*colon == NULL)) {
+            cl = _mm_movemask_epi8(_mm_cmpeq_epi8(v, cl_key));
+            http_scan_colon(p, lf, cl, colon);
+        }
+
+        if (lf) {
+            return p + __builtin_ctz(lf);
+        }
+        p += 16;
+    }
+
+    return http_scan_line_scalar(p, end, colon);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t *http_scan_line_avx2(const uint8_t *p, const uint8_t *end, const uint8_t **colon)
+{
+    __m256i v;
+    uint32_t lf = 0;
+    uint32_t cl = 0;
+    const __m256i lf_key = _mm256_set1_epi8('\n');
+    const __m256i cl_key = _mm256_set1_epi8(':');
+
+    while (end - p >= 32) {
+        v = _mm256_loadu_si256((const __m256i *)p);
+        lf = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf_key));
+        if (colon && (*colon == NULL)) {
+            cl = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cl_key));
+            http_scan_colon(p, lf, cl, colon);
+        }
+
+        if (lf) {
+            return p + __builtin_ctz(lf);
+        }
+        p += 32;
+    }
+
+    return http_scan_line_sse(p, end, colon);
+}
+#endif
+
+static http_scan_line_t http_scan_line = http_scan_line_scalar;
+
+/* any byte of the line except '\r' and the first ':' */
+static inline bool http_line_content(const uint8_t *p, const uint8_t *end, const uint8_t *colon)
+{
+    for (; p < end; p++) {
+        if ((*p != '\r') && (p != colon)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 #define CONTENT_LENGTH_NAME "Content-Length:"
 #define CONTENT_LENGTH_SIZE STRING_SIZE(CONTENT_LENGTH_NAME)
 
@@ -52,7 +152,8 @@ static inline int http_header_match(const uint8_t *start, int name_len, int name
     return 0;
 }
 
-static inline int http_parse_header_line(struct socket *sk, const uint8_t *start, int name_len, int line_len)
+static inline int http_parse_header_line(struct socket *sk, struct socket_cold *skc, const uint8_t *start,
+    int name_len, int line_len)
 {
     int i = 0;
     long content_length = 0;
@@ -63,9 +164,9 @@ static inline int http_parse_header_line(struct socket *sk, const uint8_t *start
             return -1;
         }
 
-        if ((sk->http_flags & HTTP_F_TRANSFER_ENCODING) == 0) {
-            sk->http_length = content_length;
-            sk->http_flags |= HTTP_F_CONTENT_LENGTH;
+        if ((skc->http_flags & HTTP_F_TRANSFER_ENCODING) == 0) {
+            skc->http_length = content_length;
+            skc->http_flags |= HTTP_F_CONTENT_LENGTH;
         } else {
             return -1;
         }
@@ -74,8 +175,8 @@ static inline int http_parse_header_line(struct socket *sk, const uint8_t *start
         for (i = name_len; i < line_len; i++) {
             /* 'k' stands for 'chunked' */
             if ((start[i] == 'k') || (start[i] == 'K')) {
-                if ((sk->http_flags & HTTP_F_CONTENT_LENGTH) == 0) {
-                    sk->http_flags |= HTTP_F_TRANSFER_ENCODING;
+                if ((skc->http_flags & HTTP_F_CONTENT_LENGTH) == 0) {
+                    skc->http_flags |= HTTP_F_TRANSFER_ENCODING;
                     break;
                 } else {
                     return -1;
@@ -84,7 +185,7 @@ static inline int http_parse_header_line(struct socket *sk, const uint8_t *start
         }
     } else if (http_header_match(start, name_len, CONNECTION_SIZE, 'C', 'c', 'n', 'N')) {
         if (line_len < (name_len + (int)STRING_SIZE("keep-alive") + 1)) {
-            sk->http_flags |= HTTP_F_CLOSE;
+            skc->http_flags |= HTTP_F_CLOSE;
             sk->keepalive = 0;
         }
     }
@@ -95,57 +196,55 @@ static inline int http_parse_header_line(struct socket *sk, const uint8_t *start
 /*
  * headers must be in an mbuf
  * */
-static int http_parse_headers(struct socket *sk, const uint8_t *data, int data_len)
+static int http_parse_headers(struct socket *sk, struct socket_cold *skc, const uint8_t *data, int data_len)
 {
-    const uint8_t *p = NULL;
-    const uint8_t *start = NULL;
-    const uint8_t *end = NULL;
-    uint8_t c = 0;
-    int line_len = 0;
+    const uint8_t *p = data;
+    const uint8_t *end = data + data_len;
+    const uint8_t *lf = NULL;
+    const uint8_t *colon = NULL;
     int name_len = 0;
 
-    start = data;
-    p = data;
-    end = data + data_len;
     while (p < end) {
-        c = *p;
-        p++;
-        line_len++;
-        if ((c == ':') && (name_len == 0)) {
-            name_len = line_len;
-        } else if (c == '\r') {
-            continue;
-        } else if (c == '\n') {
-            if (sk->http_parse_state == HTTP_HEADER_BEGIN) {
-                if (http_parse_header_line(sk, start, name_len, line_len) < 0) {
-                    return -1;
-                }
-                line_len = 0;
-                name_len = 0;
-                start = p;
-                sk->http_parse_state = HTTP_HEADER_LINE_END;
-            } else {
+        colon = NULL;
+        lf = http_scan_line(p, end, &colon);
+        if ((skc->http_parse_state != HTTP_HEADER_BEGIN) && http_line_content(p, lf, colon)) {
+            skc->http_parse_state = HTTP_HEADER_BEGIN;
+        }
+
+        if (lf == end) {
+            break;
+        }
+
+        if (skc->http_parse_state == HTTP_HEADER_BEGIN) {
+            name_len = colon ? (colon - p + 1) : 0;
+            if (http_parse_header_line(sk, skc, p, name_len, lf - p + 1) < 0) {
+                return -1;
+            }
+            p = lf + 1;
+            skc->http_parse_state = HTTP_HEADER_LINE_END;
+        } else {
             /* end of header */
-                sk->http_parse_state = HTTP_HEADER_DONE;
-                if (sk->http_flags == 0) {
-                    sk->http_flags = HTTP_F_CONTENT_LENGTH_AUTO | HTTP_F_CLOSE;
-                    sk->http_length = -1;
-                    sk->keepalive = 0;
-                }
-                break;
+            skc->http_parse_state = HTTP_HEADER_DONE;
+            if ((skc->http_flags == 0) && g_config.server) {
+                /* a request without a body */
+                skc->http_flags = HTTP_F_CONTENT_LENGTH;
+                skc->http_length = 0;
+            } else if (skc->http_flags == 0) {
+                skc->http_flags = HTTP_F_CONTENT_LENGTH_AUTO | HTTP_F_CLOSE;
+                skc->http_length = -1;
+                sk->keepalive = 0;
             }
-        } else if (sk->http_parse_state != HTTP_HEADER_BEGIN) {
-            sk->http_parse_state = HTTP_HEADER_BEGIN;
+            return lf + 1 - data;
         }
     }
 
-    return p - data;
+    return data_len;
 }
 
 /*
  * https://datatracker.ietf.org/doc/html/rfc7230
  * */
-static inline int http_parse_chunk(struct socket *sk, const uint8_t *data, int data_len)
+static inline int http_parse_chunk(struct socket_cold *skc, const uint8_t *data, int data_len, int *used)
 {
     uint8_t c = 0;
     int len = 0;
@@ -153,55 +252,52 @@ static inline int http_parse_chunk(struct socket *sk, const uint8_t *data, int d
     const uint8_t *p = data;
 
 retry:
-    switch (sk->http_parse_state) {
+    switch (skc->http_parse_state) {
     case HTTP_HEADER_DONE:
-        sk->http_parse_state = HTTP_CHUNK_SIZE;
+        skc->http_parse_state = HTTP_CHUNK_SIZE;
         /* fall through */
     case HTTP_CHUNK_SIZE:
         while (p < end) {
             c = *p;
             p++;
             if ((c >= '0') && (c <= '9')) {
-                sk->http_length = (sk->http_length << 4) + c - '0';
+                skc->http_length = (skc->http_length << 4) + c - '0';
             } else if ((c >= 'a') && (c <= 'f')) {
-                sk->http_length = (sk->http_length << 4) + c - 'a' + 10;
+                skc->http_length = (skc->http_length << 4) + c - 'a' + 10;
             } else {
-                sk->http_parse_state = HTTP_CHUNK_SIZE_END;
+                skc->http_parse_state = HTTP_CHUNK_SIZE_END;
                 break;
             }
         }
         /* fall through */
     case HTTP_CHUNK_SIZE_END:
-        while (p < end) {
-            c = *p;
+        /* skip chunk ext */
+        p = http_scan_line(p, end, NULL);
+        if (p < end) {
             p++;
-            if (c == '\n') {
-                if (sk->http_length > 0) {
-                    sk->http_parse_state = HTTP_CHUNK_DATA;
-                    break;
-                } else {
-                    sk->http_parse_state = HTTP_CHUNK_TRAILER_BEGIN;
-                    goto trailer_begin;
-                }
+            if (skc->http_length > 0) {
+                skc->http_parse_state = HTTP_CHUNK_DATA;
+            } else {
+                skc->http_parse_state = HTTP_CHUNK_TRAILER_BEGIN;
+                goto trailer_begin;
             }
-            /* skip chunk ext */
         }
         /* fall through */
     case HTTP_CHUNK_DATA:
         /* fall through */
         if (p < end) {
             len = end - p;
-            if (sk->http_length >= len) {
-                sk->http_length -= len;
+            if (skc->http_length >= len) {
+                skc->http_length -= len;
                 return HTTP_PARSE_OK;
             }
 
-            p += sk->http_length;
-            sk->http_length = 0;
+            p += skc->http_length;
+            skc->http_length = 0;
             c = *p;
             p++;
             if (c == '\r') {
-                sk->http_parse_state = HTTP_CHUNK_DATA_END;
+                skc->http_parse_state = HTTP_CHUNK_DATA_END;
             } else {
                 return HTTP_PARSE_ERR;
             }
@@ -214,7 +310,7 @@ retry:
             c = *p;
             p++;
             if (c == '\n') {
-                sk->http_parse_state = HTTP_CHUNK_SIZE;
+                skc->http_parse_state = HTTP_CHUNK_SIZE;
                 goto retry;
             } else {
                 return HTTP_PARSE_ERR;
@@ -229,23 +325,21 @@ trailer_begin:
             c = *p;
             p++;
             if (c == '\r') {
-                sk->http_parse_state = HTTP_CHUNK_END;
+                skc->http_parse_state = HTTP_CHUNK_END;
                 goto chunk_end;
             } else {
-                sk->http_parse_state = HTTP_CHUNK_TRAILER;
+                skc->http_parse_state = HTTP_CHUNK_TRAILER;
             }
         } else {
             return HTTP_PARSE_OK;
         }
         /* fall through */
     case HTTP_CHUNK_TRAILER:
-        while (p < end) {
-            c = *p;
+        p = http_scan_line(p, end, NULL);
+        if (p < end) {
             p++;
-            if (c == '\n') {
-                sk->http_parse_state = HTTP_CHUNK_TRAILER_BEGIN;
-                goto trailer_begin;
-            }
+            skc->http_parse_state = HTTP_CHUNK_TRAILER_BEGIN;
+            goto trailer_begin;
         }
         return HTTP_PARSE_OK;
 
@@ -255,7 +349,8 @@ chunk_end:
             c = *p;
             p++;
             if (c == '\n') {
-                sk->http_parse_state = HTTP_BODY_DONE;
+                skc->http_parse_state = HTTP_BODY_DONE;
+                *used = p - data;
                 return HTTP_PARSE_END;
             } else {
                 return HTTP_PARSE_ERR;
@@ -268,50 +363,86 @@ chunk_end:
     }
 }
 
-static inline int http_parse_body(struct socket *sk, const uint8_t *data, int data_len)
+/* 'used' is the length of the body in 'data' at the end of a message */
+static inline int http_parse_body(struct socket_cold *skc, const uint8_t *data, int data_len, int *used)
 {
-    if (sk->http_flags & HTTP_F_CONTENT_LENGTH) {
-        if (data_len < sk->http_length) {
-            sk->http_length -= data_len;
+    if (skc->http_flags & HTTP_F_CONTENT_LENGTH) {
+        if (data_len < skc->http_length) {
+            skc->http_length -= data_len;
             return HTTP_PARSE_OK;
-        } else if (data_len == sk->http_length) {
-            sk->http_length = 0;
-            sk->http_parse_state = HTTP_BODY_DONE;
-            return HTTP_PARSE_END;
         } else {
-            return HTTP_PARSE_ERR;
-            return -1;
+            /* the next message of a pipeline follows */
+            *used = skc->http_length;
+            skc->http_length = 0;
+            skc->http_parse_state = HTTP_BODY_DONE;
+            return HTTP_PARSE_END;
         }
-    } else if (sk->http_flags & HTTP_F_TRANSFER_ENCODING) {
-        return http_parse_chunk(sk, data, data_len);
+    } else if (skc->http_flags & HTTP_F_TRANSFER_ENCODING) {
+        return http_parse_chunk(skc, data, data_len, used);
     } else {
         return HTTP_PARSE_OK;
     }
 }
 
-int http_parse_run(struct socket *sk, const uint8_t *data, int data_len)
+/* responses of a client, or requests of a server, back to back */
+int http_parse_run(struct socket *sk, struct socket_cold *skc, const uint8_t *data, int data_len)
 {
     int len = 0;
+    int ret = HTTP_PARSE_OK;
 
-    if (sk->http_parse_state == HTTP_INIT) {
-        http_parse_response(data, data_len);
-        sk->http_parse_state = HTTP_HEADER_BEGIN;
-    }
+    while (data_len > 0) {
+        if (skc->http_parse_state == HTTP_INIT) {
+            if (g_config.server) {
+                http_parse_request(data, data_len);
+            } else {
+                http_parse_response(data, data_len);
+            }
+            skc->http_parse_state = HTTP_HEADER_BEGIN;
+        }
+
+        if (skc->http_parse_state < HTTP_HEADER_DONE) {
+            len = http_parse_headers(sk, skc, data, data_len);
+            if (len < 0) {
+                return HTTP_PARSE_ERR;
+            }
 
-    if (sk->http_parse_state < HTTP_HEADER_DONE) {
-        len = http_parse_headers(sk, data, data_len);
-        if (len < 0) {
-            return HTTP_PARSE_ERR;
+            data += len;
+            data_len -= len;
+            if (skc->http_parse_state < HTTP_HEADER_DONE) {
+                return HTTP_PARSE_OK;
+            }
+        }
+
+        len = 0;
+        ret = http_parse_body(skc, data, data_len, &len);
+        if (ret != HTTP_PARSE_END) {
+            return ret;
         }
 
         data += len;
         data_len -= len;
+        skc->http_done++;
+        skc->http_length = 0;
+        skc->http_parse_state = HTTP_INIT;
+        skc->http_flags = 0;
     }
 
-    if (data_len >= 0) {
-        return http_parse_body(sk, data, data_len);
-    } else {
-        return HTTP_PARSE_OK;
+    return ret;
+}
+
+/* called once before the workers start */
+void http_parse_init(void)
+{
+#ifdef __SSE2__
+    http_scan_line = http_scan_line_sse;
+    if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) > 0) {
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 11, 0, 0)
+        if (rte_vect_get_max_simd_bitwidth() < RTE_VECT_SIMD_256) {
+            return;
+        }
+#endif
+        http_scan_line = http_scan_line_avx2;
     }
+#endif
 }
 #endif
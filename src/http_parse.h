@@ -52,7 +52,8 @@ enum {
  *  1   end
  *  -1  error
  * */
-int http_parse_run(struct socket *sk, const uint8_t *data, int data_len);
+int http_parse_run(struct socket *sk, struct socket_cold *skc, const uint8_t *data, int data_len);
+void http_parse_init(void);
 
 
 #endif
@@ -27,6 +27,7 @@
 #include "lldp.h"
 #include "kni.h"
 #include "socket_timer.h"
+#include "gro.h"
 #include <rte_ip_frag.h>
 
 /* optimal value, don't change */
@@ -268,6 +269,10 @@ static inline int slow_timer_run(struct work_space *ws)
         kni_send(ws);
     }
 
+    if (unlikely(ws->socket_table.chunk_pending) && (!ws->socket_table.sparse)) {
+        socket_table_init_background(ws);
+    }
+
     ms100 = tsc_time_go(&tt->ms100, tt->tsc);
     if (unlikely(ms100 > 0)) {
         /*
@@ -302,6 +307,10 @@ static inline int client_recv_mbuf(struct work_space *ws, l3_input_t l3_input,
 
     nb_rx = rte_eth_rx_burst(port, queue, mbuf_rx, RX_BURST_MAX);
     if (nb_rx) {
+        if (ws->gro) {
+            nb_rx = gro_merge(ws, mbuf_rx, nb_rx);
+        }
+
         if (nb_rx > MBUF_PREFETCH_NUM) {
             for (i = 0; i < MBUF_PREFETCH_NUM; i++) {
                 mbuf_prefetch(mbuf_rx[i]);
@@ -370,6 +379,10 @@ static inline void server_loop(struct work_space *ws, l3_input_t l3_input,
 
         /* step 2. process timer */
         tick_time_update(tt);
+        if (ws->ack_delay.head != ws->ack_delay.tail) {
+            work += tcp_ack_delay_run(ws);
+        }
+
         ticks = tsc_time_go(&tt->tick, tt->tsc);
         CPULOAD_ADD_TSC(&ws->load, tt->tsc, work);
         if (unlikely(ticks > 0)) {
@@ -400,12 +413,12 @@ static inline void client_loop(struct work_space *ws, l3_input_t l3_input,
         tick_time_update(tt);
         CPULOAD_ADD_TSC(&ws->load, tt->tsc, work);
         work += client_launch(ws);
+        if (ws->ack_delay.head != ws->ack_delay.tail) {
+            work += tcp_ack_delay_run(ws);
+        }
+
         ticks = tsc_time_go(&tt->tick, tt->tsc);
         if (unlikely(ticks > 0)) {
-            if (ws->ack_delay.next) {
-                tcp_ack_delay_flush(ws);
-            }
-
             work = 1;
             if (unlikely(slow_timer_run(ws) < 0)) {
                 break;
@@ -27,35 +27,42 @@
 #include "work_space.h"
 #include "icmp6.h"
 
-#define NB_MBUF             (8192 * 8)
-
 __thread struct mbuf_free_pool g_mbuf_free_pool = {0};
 
-struct rte_mempool *mbuf_pool_create(const char *str, uint16_t port_id, uint16_t queue_id)
+/* socket_id: the numa node of the lcore using this pool */
+struct rte_mempool *mbuf_pool_create_size(const char *str, uint16_t port_id, uint16_t queue_id, int socket_id,
+    uint32_t num, uint16_t data_size)
 {
-    int socket_id = 0;
     char name[RTE_RING_NAMESIZE];
     struct rte_mempool *mbuf_pool = NULL;
-    int mbuf_size = 0;
+    uint32_t cache_size = RTE_MEMPOOL_CACHE_MAX_SIZE;
 
-    socket_id = rte_eth_dev_socket_id(port_id);
     snprintf(name, RTE_RING_NAMESIZE, "%s_%d_%d", str, port_id, queue_id);
 
-    if (g_config.jumbo) {
-        mbuf_size = JUMBO_MBUF_SIZE;
-    } else {
-        mbuf_size = RTE_MBUF_DEFAULT_BUF_SIZE;
+    if (cache_size > num / 2) {
+        cache_size = 0;
     }
 
-    mbuf_pool = rte_pktmbuf_pool_create(name, NB_MBUF,
-                RTE_MEMPOOL_CACHE_MAX_SIZE, 0, mbuf_size, socket_id);
-
+    mbuf_pool = rte_pktmbuf_pool_create(name, num, cache_size, 0, data_size, socket_id);
     if (mbuf_pool == NULL) {
         printf("rte_pkt_pool_create error\n");
     }
     return mbuf_pool;
 }
 
+struct rte_mempool *mbuf_pool_create(const char *str, uint16_t port_id, uint16_t queue_id, int socket_id)
+{
+    int mbuf_size = 0;
+
+    if (g_config.jumbo) {
+        mbuf_size = JUMBO_MBUF_SIZE;
+    } else {
+        mbuf_size = RTE_MBUF_DEFAULT_BUF_SIZE;
+    }
+
+    return mbuf_pool_create_size(str, port_id, queue_id, socket_id, NB_MBUF, mbuf_size);
+}
+
 void mbuf_log(struct rte_mbuf *m, const char *tag)
 {
     uint8_t flags = 0;
@@ -33,6 +33,8 @@
 #include "ip.h"
 #include "icmp.h"
 
+#define NB_MBUF             (8192 * 8)
+
 #define mbuf_eth_hdr(m) rte_pktmbuf_mtod(m, struct eth_hdr *)
 #define mbuf_arphdr(m) rte_pktmbuf_mtod_offset(m, struct arphdr*, sizeof(struct eth_hdr))
 #define mbuf_ip_hdr(m) rte_pktmbuf_mtod_offset(m, struct iphdr*, sizeof(struct eth_hdr))
@@ -75,7 +77,9 @@ void mbuf_log(struct rte_mbuf *m, const char *tag);
 #endif
 
 int mbuf_pool_init(struct config *cfg);
-struct rte_mempool *mbuf_pool_create(const char *str, uint16_t port_id, uint16_t queue_id);
+struct rte_mempool *mbuf_pool_create(const char *str, uint16_t port_id, uint16_t queue_id, int socket_id);
+struct rte_mempool *mbuf_pool_create_size(const char *str, uint16_t port_id, uint16_t queue_id, int socket_id,
+    uint32_t num, uint16_t data_size);
 
 #define MBUF_FREE_POOL_SIZE 128
 
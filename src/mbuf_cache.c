@@ -32,6 +32,53 @@ struct tcp_opt_mss {
     uint16_t mss;
 } __attribute__((__packed__));
 
+/*
+ * The payload is in one mbuf for the whole life of the cache, so the pool of
+ * indirect mbufs is kept small enough for its 16-bit reference count.
+ * */
+static int mbuf_cache_init_split(struct mbuf_cache *pool, const char *name, struct work_space *ws)
+{
+    char str[RTE_RING_NAMESIZE];
+    uint8_t *data = NULL;
+    struct mbuf_data *mdata = &pool->data;
+    struct rte_mempool *mp = NULL;
+    int socket_id = rte_socket_id();
+
+    pool->len = mdata->total_len - mdata->data_len;
+    pool->mbuf_pool = mbuf_pool_create_size(name, ws->port->id, ws->queue_id, socket_id,
+            NB_MBUF, RTE_PKTMBUF_HEADROOM + pool->len);
+    if (pool->mbuf_pool == NULL) {
+        return -1;
+    }
+
+    snprintf(str, sizeof(str), "%s_i", name);
+    pool->indirect_pool = mbuf_pool_create_size(str, ws->port->id, ws->queue_id, socket_id, NB_MBUF / 2, 0);
+    if (pool->indirect_pool == NULL) {
+        return -1;
+    }
+
+    snprintf(str, sizeof(str), "%s_p", name);
+    mp = mbuf_pool_create_size(str, ws->port->id, ws->queue_id, socket_id, 1, RTE_PKTMBUF_HEADROOM + mdata->data_len);
+    if (mp == NULL) {
+        return -1;
+    }
+
+    pool->payload = rte_pktmbuf_alloc(mp);
+    if (pool->payload == NULL) {
+        return -1;
+    }
+
+    data = mbuf_push_data(pool->payload, mdata->data_len);
+    memcpy(data, mdata->data + pool->len, mdata->data_len);
+    return 0;
+}
+
+/* tx_split is only for templates with data, the large payload file has its own data segments */
+static bool mbuf_cache_split(struct work_space *ws, struct mbuf_data *mdata)
+{
+    return g_dev_tx_split && (mdata->data_len > 0) && (ws->payload_object == 0);
+}
+
 static int mbuf_cache_init(struct mbuf_cache *pool, const char *name, struct work_space *ws, struct mbuf_data *mdata)
 {
     if (ws->cfg->vxlan) {
@@ -40,12 +87,17 @@ static int mbuf_cache_init(struct mbuf_cache *pool, const char *name, struct wor
         }
     }
 
-    pool->mbuf_pool = mbuf_pool_create(name, ws->port->id, ws->queue_id);
+    memcpy(&pool->data, mdata, sizeof(struct mbuf_data));
+    if (mbuf_cache_split(ws, mdata)) {
+        return mbuf_cache_init_split(pool, name, ws);
+    }
+
+    pool->len = mdata->total_len;
+    pool->mbuf_pool = mbuf_pool_create(name, ws->port->id, ws->queue_id, rte_socket_id());
     if (pool->mbuf_pool == NULL) {
         return -1;
     }
 
-    memcpy(&pool->data, mdata, sizeof(struct mbuf_data));
     return 0;
 }
 
@@ -210,7 +262,7 @@ static int mbuf_data_push_tcp_opt(struct mbuf_data *mdata, void *data, int len)
         return -1;
     }
     th = mbuf_data_tcphdr(mdata);
-    th->th_off++;
+    th->th_off += len / 4;
     mdata->l4_len += len;
     if (mbuf_data_push(mdata, (uint8_t*)data, len) != 0) {
         return -1;
@@ -246,6 +298,29 @@ static int mbuf_data_push_tcp_wscale(struct mbuf_data *mdata)
     return mbuf_data_push_tcp_opt(mdata, (void *)wscale, 4);
 }
 
+static int mbuf_data_push_tcp_sack_permitted(struct mbuf_data *mdata)
+{
+    /*
+     * nop, nop
+     * kind = 4, len = 2
+     * */
+    uint8_t sack[4] = {1, 1, 4, 2};
+
+    return mbuf_data_push_tcp_opt(mdata, (void *)sack, 4);
+}
+
+static int mbuf_data_push_tcp_timestamps(struct mbuf_data *mdata)
+{
+    /*
+     * nop, nop
+     * kind = 8, len = 10, TSval, TSecr
+     * the values are written by tcp_ts_write()
+     * */
+    uint8_t ts[TCPOLEN_TSTAMP_APPA] = {1, 1, 8, 10};
+
+    return mbuf_data_push_tcp_opt(mdata, (void *)ts, TCPOLEN_TSTAMP_APPA);
+}
+
 static int mbuf_data_push_udp(struct mbuf_data *mdata)
 {
     struct udphdr uh;
@@ -301,6 +376,11 @@ int mbuf_cache_init_tcp(struct mbuf_cache *cache, struct work_space *ws, const c
         return -1;
     }
 
+    /* the first option of all segments, at a fixed offset */
+    if (ws->cfg->timestamps && (mbuf_data_push_tcp_timestamps(&mdata) < 0)) {
+        return -1;
+    }
+
     if (mss > 0) {
         if (mbuf_data_push_tcp_mss(&mdata, mss) < 0) {
             return -1;
@@ -309,6 +389,10 @@ int mbuf_cache_init_tcp(struct mbuf_cache *cache, struct work_space *ws, const c
         if (mbuf_data_push_tcp_wscale(&mdata) < 0) {
             return -1;
         }
+
+        if (ws->cfg->sack && (mbuf_data_push_tcp_sack_permitted(&mdata) < 0)) {
+            return -1;
+        }
     }
 
     if (mbuf_data_push_data(&mdata, data) < 0) {
@@ -37,8 +37,15 @@ struct mbuf_data {
     uint16_t total_len;
 };
 
+/*
+ * tx_split: mbuf_pool only caches the headers, each packet chains an indirect mbuf
+ * of the shared 'payload', which holds the data of the template.
+ * */
 struct mbuf_cache {
     struct rte_mempool *mbuf_pool;
+    struct rte_mempool *indirect_pool;
+    struct rte_mbuf *payload;
+    uint16_t len; /* template bytes in an mbuf of mbuf_pool */
     struct mbuf_data data;
 };
 
@@ -62,10 +69,24 @@ static inline void *mbuf_get_userdata(struct rte_mbuf *m)
 #endif
 }
 
+static inline struct rte_mbuf *mbuf_cache_attach_payload(struct mbuf_cache *p)
+{
+    struct rte_mbuf *m = NULL;
+
+    m = rte_pktmbuf_alloc(p->indirect_pool);
+    if (unlikely(m == NULL)) {
+        return NULL;
+    }
+
+    rte_pktmbuf_attach(m, p->payload);
+    return m;
+}
+
 static inline struct rte_mbuf *mbuf_cache_alloc(struct mbuf_cache *p)
 {
     uint8_t *data = NULL;
     struct rte_mbuf *m = NULL;
+    struct rte_mbuf *seg = NULL;
 
     m = rte_pktmbuf_alloc(p->mbuf_pool);
     if (unlikely(m == NULL)) {
@@ -73,11 +94,37 @@ static inline struct rte_mbuf *mbuf_cache_alloc(struct mbuf_cache *p)
     }
 
     if (likely(mbuf_get_userdata(m) == p)) {
-        mbuf_push_data(m, p->data.total_len);
+        mbuf_push_data(m, p->len);
     } else {
         mbuf_set_userdata(m, p);
-        data = mbuf_push_data(m, p->data.total_len);
-        memcpy(data, p->data.data, p->data.total_len);
+        data = mbuf_push_data(m, p->len);
+        memcpy(data, p->data.data, p->len);
+    }
+
+    if (p->payload) {
+        seg = mbuf_cache_attach_payload(p);
+        if (unlikely(seg == NULL)) {
+            rte_pktmbuf_free(m);
+            return NULL;
+        }
+        rte_pktmbuf_chain(m, seg);
+    }
+
+    return m;
+}
+
+/* the data of the template without headers */
+static inline struct rte_mbuf *mbuf_cache_alloc_payload(struct mbuf_cache *p)
+{
+    struct rte_mbuf *m = NULL;
+
+    if (p->payload) {
+        return mbuf_cache_attach_payload(p);
+    }
+
+    m = mbuf_cache_alloc(p);
+    if (likely(m != NULL)) {
+        rte_pktmbuf_adj(m, p->data.total_len - p->data.data_len);
     }
 
     return m;
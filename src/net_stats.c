@@ -126,10 +126,9 @@ static void net_stats_format_print3(uint64_t val, char *buf, int len, int space,
     }                                           \
 } while (0)
 
-static void net_stats_print_rtt(struct net_stats *stats, char rtt_str[], int len)
+/* the average of 'num' samples in tsc, printed in us */
+static void net_stats_print_us(uint64_t rtt_tsc, uint64_t rtt_num, char rtt_str[], int len)
 {
-    uint64_t rtt_tsc = stats->rtt_tsc;
-    uint64_t rtt_num = stats->rtt_num;
     uint64_t tsc_per_us = TSC_PER_SEC / (1000 * 1000);
     uint64_t rtt_us = 0;
     uint64_t rtt_us_minor = 0;
@@ -149,6 +148,11 @@ static void net_stats_print_rtt(struct net_stats *stats, char rtt_str[], int len
     snprintf(rtt_str, len, "%-10s", rtt2);
 }
 
+static void net_stats_print_rtt(struct net_stats *stats, char rtt_str[], int len)
+{
+    net_stats_print_us(stats->rtt_tsc, stats->rtt_num, rtt_str, len);
+}
+
 static int net_stats_print_socket(struct net_stats *stats, char *buf, int buf_len)
 {
     char *p = buf;
@@ -331,6 +335,16 @@ static int net_stats_print_retransmit(struct net_stats *stats, char *buf, int bu
 
     char udp_rt[STATS_BUF_LEN];
     char udp_drop[STATS_BUF_LEN];
+    char reorder[STATS_BUF_LEN];
+    char reorder_depth[STATS_BUF_LEN];
+    char reorder_drop[STATS_BUF_LEN];
+    uint64_t depth = 0;
+    char udp_lost[STATS_BUF_LEN];
+    char udp_late[STATS_BUF_LEN];
+    char udp_dup[STATS_BUF_LEN];
+    char jitter[STATS_BUF_LEN];
+    char owd[STATS_BUF_LEN];
+    uint64_t lost = 0;
     int len = buf_len;
 
     net_stats_format_print_err(stats->tcp_drop, tcp_drop, STATS_BUF_LEN);
@@ -345,9 +359,32 @@ static int net_stats_print_retransmit(struct net_stats *stats, char *buf, int bu
         SNPRINTF(p, len, "synRt   %s finRt    %s ackRt    %s pushRt  %s\n",
             syn_rt, fin_rt, ack_rt, push_rt);
         SNPRINTF(p, len, "tcpDrop %s udpDrop  %s ackDup   %s\n", tcp_drop, udp_drop, ack_dup);
+        if (g_config.rx_reorder) {
+            /* average queue length when a segment is queued */
+            if (stats->tcp_reorder) {
+                depth = stats->tcp_reorder_depth / stats->tcp_reorder;
+            }
+            net_stats_format_print(stats->tcp_reorder, reorder, STATS_BUF_LEN);
+            net_stats_format_print(depth, reorder_depth, STATS_BUF_LEN);
+            net_stats_format_print_err(stats->tcp_reorder_drop, reorder_drop, STATS_BUF_LEN);
+            SNPRINTF(p, len, "reorder %s rdDepth  %s rdDrop   %s\n", reorder, reorder_depth, reorder_drop);
+        }
     } else {
         net_stats_format_print_err(stats->udp_rt, udp_rt, STATS_BUF_LEN);
         SNPRINTF(p, len, "udpRt   %s udpDrop  %s tcpDrop  %s\n", udp_rt, udp_drop, tcp_drop);
+        if (g_config.udp_seq) {
+            /* late packets were counted in the gaps */
+            if (stats->udp_seq_gap > stats->udp_seq_late) {
+                lost = stats->udp_seq_gap - stats->udp_seq_late;
+            }
+            net_stats_format_print_err(lost, udp_lost, STATS_BUF_LEN);
+            net_stats_format_print_err(stats->udp_seq_late, udp_late, STATS_BUF_LEN);
+            net_stats_format_print_err(stats->udp_seq_dup, udp_dup, STATS_BUF_LEN);
+            net_stats_print_us(stats->udp_jitter_tsc, stats->udp_jitter_num, jitter, STATS_BUF_LEN);
+            net_stats_print_us(stats->udp_owd_tsc, stats->udp_jitter_num, owd, STATS_BUF_LEN);
+            SNPRINTF(p, len, "udpLost %s udpLate  %s udpDup   %s\n", udp_lost, udp_late, udp_dup);
+            SNPRINTF(p, len, "jitter  %s owd      %s\n", jitter, owd);
+        }
     }
     return p - buf;
 
@@ -72,12 +72,22 @@ struct net_stats {
     uint64_t http_error;
 
     uint64_t tcp_drop;
+    uint64_t tcp_reorder;       /* segments queued out of order */
+    uint64_t tcp_reorder_depth; /* sum of the queue lengths after each of them */
+    uint64_t tcp_reorder_drop;
 
     /* udp */
     uint64_t udp_rx;
     uint64_t udp_tx;
     uint64_t udp_rt;
     uint64_t udp_drop;
+    /* udp_seq */
+    uint64_t udp_seq_gap;       /* sequences skipped, some of them arrive late */
+    uint64_t udp_seq_late;
+    uint64_t udp_seq_dup;
+    uint64_t udp_jitter_tsc;
+    uint64_t udp_jitter_num;
+    uint64_t udp_owd_tsc;       /* one-way delay, only meaningful if both ends share the tsc */
 
     /* arp */
     uint64_t arp_rx;
@@ -118,11 +128,21 @@ extern __thread struct net_stats g_net_stats;
 #define net_stats_rx_bad()          do {g_net_stats.rx_bad++;} while (0)
 
 #define net_stats_udp_rt()          do {g_net_stats.udp_rt++;} while (0)
+#define net_stats_udp_seq_gap(n)    do {g_net_stats.udp_seq_gap += (n);} while (0)
+#define net_stats_udp_seq_late()    do {g_net_stats.udp_seq_late++;} while (0)
+#define net_stats_udp_seq_dup()     do {g_net_stats.udp_seq_dup++;} while (0)
+#define net_stats_udp_jitter(tsc, owd)  do {                                            \
+                                        g_net_stats.udp_jitter_tsc += (tsc);            \
+                                        g_net_stats.udp_jitter_num++;                   \
+                                        g_net_stats.udp_owd_tsc += (owd);               \
+                                    } while (0)
 #define net_stats_syn_rt()          do {g_net_stats.syn_rt++;} while (0)
 #define net_stats_fin_rt()          do {g_net_stats.fin_rt++;} while (0)
 #define net_stats_ack_rt()          do {g_net_stats.ack_rt++;} while (0)
 #define net_stats_push_rt()         do {g_net_stats.push_rt++;} while (0)
 #define net_stats_ack_dup()         do {g_net_stats.ack_dup++;} while (0)
+#define net_stats_tcp_reorder(n)    do {g_net_stats.tcp_reorder++; g_net_stats.tcp_reorder_depth += (n);} while (0)
+#define net_stats_tcp_reorder_drop() do {g_net_stats.tcp_reorder_drop++;} while (0)
 
 #define net_stats_pkt_lost()        do {g_net_stats.pkt_lost++;} while (0)
 
@@ -160,10 +180,21 @@ extern __thread struct net_stats g_net_stats;
                                         g_net_stats.pkt_tx++;                           \
                                         g_net_stats.byte_tx += rte_pktmbuf_data_len(m); \
                                     } while (0)
+/* the segments of a tso packet after the first one */
+#define net_stats_tso_tx(num, len)  do {                                                \
+                                        g_net_stats.pkt_tx += (num);                    \
+                                        g_net_stats.tcp_tx += (num);                    \
+                                        g_net_stats.byte_tx += (uint64_t)(num) * (len); \
+                                    } while (0)
 #define net_stats_rtt(ws, sk)       do {                                                            \
                                         g_net_stats.rtt_num++;                                      \
                                         g_net_stats.rtt_tsc += work_space_tsc(ws) - sk->timer_tsc;  \
                                     } while (0)
+/* a sample from the timestamps option */
+#define net_stats_rtt_tsc(tsc)      do {                                                            \
+                                        g_net_stats.rtt_num++;                                      \
+                                        g_net_stats.rtt_tsc += (tsc);                               \
+                                    } while (0)
 
 #define net_stats_tos_ipv4_rx(ws, iph)  do {                                            \
                                         if (ws->tos && (ws->tos == iph->tos)) {         \
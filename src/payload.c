@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "payload.h"
+
+#include <stdio.h>
+#include <rte_memzone.h>
+#include <rte_version.h>
+
+#include "config.h"
+
+#define PAYLOAD_OBJECT_NAME "payload_object"
+
+struct payload_object g_payload_object;
+
+static int payload_object_read(const char *path, uint8_t *data, uint32_t size)
+{
+    FILE *fp = NULL;
+    size_t ret = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("Error: cannot open file: %s\n", path);
+        return -1;
+    }
+
+    ret = fread(data, 1, size, fp);
+    fclose(fp);
+    if (ret != size) {
+        printf("Error: read file error: %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+#if RTE_VERSION >= RTE_VERSION_NUM(18, 5, 0, 0)
+/*
+ * The object is read into an iova contiguous memzone, so that each slice
+ * is one dma segment. A mapping of the file cannot be used by the nic.
+ * */
+static int payload_object_reserve(struct config *cfg)
+{
+    const struct rte_memzone *mz = NULL;
+    uint32_t size = cfg->payload_size[0];
+
+    mz = rte_memzone_reserve_aligned(PAYLOAD_OBJECT_NAME, size, SOCKET_ID_ANY,
+            RTE_MEMZONE_IOVA_CONTIG, RTE_CACHE_LINE_SIZE);
+    if (mz == NULL) {
+        printf("Error: no contiguous hugepages for 'payload_file' of %u bytes\n", size);
+        return -1;
+    }
+
+    if (payload_object_read(cfg->payload_path, mz->addr, size) < 0) {
+        rte_memzone_free(mz);
+        return -1;
+    }
+
+    g_payload_object.data = mz->addr;
+    g_payload_object.iova = mz->iova;
+    g_payload_object.size = size;
+
+    return 0;
+}
+#endif
+
+int payload_object_load(struct config *cfg)
+{
+    if (!cfg->payload_object) {
+        return 0;
+    }
+
+#if RTE_VERSION >= RTE_VERSION_NUM(18, 5, 0, 0)
+    return payload_object_reserve(cfg);
+#else
+    printf("Error: large 'payload_file' requires dpdk 18.05 or later\n");
+    return -1;
+#endif
+}
+
+#if RTE_VERSION >= RTE_VERSION_NUM(18, 5, 0, 0)
+struct rte_mbuf_ext_shared_info g_payload_object_shinfo[THREAD_NUM_MAX];
+
+/* the object is never freed */
+static void payload_object_free(__rte_unused void *addr, __rte_unused void *opaque)
+{
+}
+
+void payload_object_init(int id)
+{
+    struct rte_mbuf_ext_shared_info *shinfo = &g_payload_object_shinfo[id];
+
+    shinfo->free_cb = payload_object_free;
+    shinfo->fcb_opaque = NULL;
+    rte_mbuf_ext_refcnt_set(shinfo, 1);
+}
+#else
+void payload_object_init(__rte_unused int id)
+{
+}
+#endif
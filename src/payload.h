@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __PAYLOAD_H
+#define __PAYLOAD_H
+
+#include <stdint.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+#include <rte_version.h>
+
+#include "config.h"
+
+/*
+ * A payload_file larger than a segment is the whole response of a tcp server.
+ * It is loaded once into hugepages, and data segments attach slices of it
+ * as external buffers, at the offset of their sequence number.
+ * */
+struct payload_object {
+    uint8_t *data;
+    rte_iova_t iova;
+    uint32_t size;
+};
+
+extern struct payload_object g_payload_object;
+
+int payload_object_load(struct config *cfg);
+void payload_object_init(int id);
+
+#if RTE_VERSION >= RTE_VERSION_NUM(18, 5, 0, 0)
+/* each worker counts the references of its own slices */
+extern struct rte_mbuf_ext_shared_info g_payload_object_shinfo[THREAD_NUM_MAX];
+
+static inline struct rte_mbuf *payload_object_slice(struct rte_mempool *pool, int id, uint32_t offset, uint16_t len)
+{
+    struct rte_mbuf *m = NULL;
+    struct rte_mbuf_ext_shared_info *shinfo = &g_payload_object_shinfo[id];
+
+    m = rte_pktmbuf_alloc(pool);
+    if (unlikely(m == NULL)) {
+        return NULL;
+    }
+
+    rte_mbuf_ext_refcnt_update(shinfo, 1);
+    rte_pktmbuf_attach_extbuf(m, g_payload_object.data + offset, g_payload_object.iova + offset, len, shinfo);
+    m->data_len = len;
+    m->pkt_len = len;
+
+    return m;
+}
+#else
+/* not loaded, see payload_object_load() */
+static inline struct rte_mbuf *payload_object_slice(__rte_unused struct rte_mempool *pool, __rte_unused int id,
+    __rte_unused uint32_t offset, __rte_unused uint16_t len)
+{
+    return NULL;
+}
+#endif
+
+#endif
@@ -31,6 +31,9 @@
 
 uint8_t g_dev_tx_offload_ipv4_cksum;
 uint8_t g_dev_tx_offload_tcpudp_cksum;
+uint8_t g_dev_tx_offload_tcp_tso;
+uint16_t g_dev_tx_tso_seg_max;
+uint8_t g_dev_tx_split;
 
 static struct rte_eth_conf g_port_conf = {
     .rxmode = {
@@ -76,10 +79,13 @@ static int port_init_rx(struct netif_port *port, int rxq, int nb_rxd)
 static int port_init_mbuf_pool(struct netif_port *port)
 {
     int i = 0;
+    int lcore_id = 0;
     struct rte_mempool *mbuf_pool = NULL;
 
     for (i = 0; i < port->queue_num; i++) {
-        mbuf_pool = mbuf_pool_create("mp", port->id, i);
+        /* rx mbufs are allocated and freed by the worker of this queue, see config_port_get() */
+        lcore_id = (port - g_config.ports) * port->queue_num + i;
+        mbuf_pool = mbuf_pool_create("mp", port->id, i, rte_lcore_to_socket_id(lcore_id));
         if (mbuf_pool == NULL) {
             goto err;
         }
@@ -176,6 +182,43 @@ int port_config(struct netif_port *port)
         g_dev_tx_offload_tcpudp_cksum = 0;
     }
 
+    /* lro packets are multi-segment mbufs, like the ones of software gro */
+    if (g_config.gro && (dev_info.rx_offload_capa & RTE_ETH_RX_OFFLOAD_TCP_LRO)) {
+        g_port_conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_TCP_LRO;
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 11, 0, 0)
+        g_port_conf.rxmode.max_lro_pkt_size = dev_info.max_lro_pkt_size;
+#endif
+    }
+
+    /* tso needs the tcp checksum offload */
+    g_dev_tx_offload_tcp_tso = 0;
+    if (g_config.tso) {
+        if (g_dev_tx_offload_tcpudp_cksum && (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_TCP_TSO)) {
+            g_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_TCP_TSO;
+            g_dev_tx_offload_tcp_tso = 1;
+            g_dev_tx_tso_seg_max = dev_info.tx_desc_lim.nb_seg_max;
+        } else {
+            printf("Warning: port %d does not support tso, segment in software\n", port_id);
+        }
+    }
+
+    /* the checksum of a split packet can only be computed by the nic */
+    g_dev_tx_split = 0;
+    if (g_config.tx_split) {
+        if (g_dev_tx_offload_tcpudp_cksum && (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MULTI_SEGS)) {
+            g_dev_tx_split = 1;
+        } else {
+            printf("Warning: port %d does not support tx_split, send linear packets\n", port_id);
+        }
+    }
+
+    /* tso, tx_split and large payload files send mbuf chains */
+    if (g_dev_tx_offload_tcp_tso || g_dev_tx_split || g_config.payload_object) {
+        if (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MULTI_SEGS) {
+            g_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MULTI_SEGS;
+        }
+    }
+
     if ((queue_num > (dev_info.max_rx_queues)) || (queue_num > (dev_info.max_tx_queues))) {
         printf("bad queue_num %d max rx %d max tx %d\n", queue_num, dev_info.max_rx_queues, dev_info.max_tx_queues);
         return -1;
@@ -90,6 +90,9 @@ struct netif_port {
 
 extern uint8_t g_dev_tx_offload_ipv4_cksum;
 extern uint8_t g_dev_tx_offload_tcpudp_cksum;
+extern uint8_t g_dev_tx_offload_tcp_tso;
+extern uint16_t g_dev_tx_tso_seg_max;
+extern uint8_t g_dev_tx_split;
 
 struct config;
 int port_init_all(struct config *cfg);
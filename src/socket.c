@@ -98,42 +98,29 @@ static void socket_init(struct work_space *ws, struct socket *sk, uint32_t clien
         sk->lport = client_port;
     }
 
-    seed = (uint32_t)rte_rdtsc();
-    sk->snd_nxt = rand_r(&seed);
+    /* udp sockets have no sequences */
+    if (ws->cfg->protocol == IPPROTO_TCP) {
+        seed = (uint32_t)rte_rdtsc();
+        sk->snd_nxt = rand_r(&seed);
+    }
 
     csum_init_socket(ws, sk);
     socket_node_init(&sk->node);
 }
 
-static struct socket_port_table *socket_port_table_new(struct work_space *ws, struct socket_table *st,
-    uint32_t client_ip)
+/* sockets are initialized by socket_table_init_chunk() */
+static struct socket_port_table *socket_port_table_new(struct socket_table *st)
 {
-    int port = 0;
-    uint32_t server_ip = 0;
-    uint16_t client_port = 0;
-    uint16_t server_port = 0;
-    struct socket *sk = NULL;
     struct socket_port_table *table = NULL;
     struct socket_pool *sp = &st->socket_pool;
 
-    table = (struct socket_port_table *)(&(sp->base[sp->next]));
-    /* skip port 0 */
-    for (port = st->client_port_min; port <= st->client_port_max; port++) {
-        for (server_port = st->server_port_min; server_port <= st->server_port_max; server_port++) {
-            client_port = port;
-            for (server_ip = st->server_ip_min; server_ip <= st->server_ip_max; server_ip++) {
-                sk = socket_port_table_get(st, table, client_port, server_port, server_ip);
-                socket_init(ws, sk, client_ip, htons(client_port), htonl(server_ip), htons(server_port));
-                sp->next++;
-            }
-        }
-    }
+    table = (struct socket_port_table *)socket_pool_get(st, sp->next);
+    sp->next += (uint32_t)st->client_port_num * st->server_ip_port_num;
 
     return table;
 }
 
-static void socket_port_table_init_ip_range(struct work_space *ws, struct socket_table *st,
-    struct ip_range *client_ip_range)
+static void socket_port_table_init_ip_range(struct socket_table *st, struct ip_range *client_ip_range)
 {
     int i = 0;
     uint32_t client_ip_low = 0;
@@ -142,20 +129,274 @@ static void socket_port_table_init_ip_range(struct work_space *ws, struct socket
 
     for (i = 0; i < client_ip_range->num; i++) {
         client_ip = ip_range_get(client_ip_range, i);
-        pt = socket_port_table_new(ws, st, client_ip);
+        pt = socket_port_table_new(st);
         client_ip_low = ntohl(client_ip) & 0xffff;
         st->ht[client_ip_low] = pt;
     }
 }
 
-static void socket_port_table_init_ip_group(struct work_space *ws, struct socket_table *st,
-    struct ip_group *ip_group)
+static void socket_port_table_init_ip_group(struct socket_table *st, struct ip_group *ip_group)
 {
     struct ip_range *ip_range = NULL;
 
     for_each_ip_range(ip_group, ip_range) {
-        socket_port_table_init_ip_range(ws, st, ip_range);
+        socket_port_table_init_ip_range(st, ip_range);
+    }
+}
+
+/* the client ip of the idx-th socket_port_table, in the order of socket_table_init() */
+static uint32_t socket_table_client_ip(struct work_space *ws, uint32_t idx)
+{
+    struct ip_range *ip_range = NULL;
+
+    if (!ws->server) {
+        return ip_range_get(&ws->port->client_ip_range, idx);
+    }
+
+    for_each_ip_range(&ws->cfg->client_ip_group, ip_range) {
+        if (idx < (uint32_t)ip_range->num) {
+            return ip_range_get(ip_range, idx);
+        }
+        idx -= ip_range->num;
+    }
+
+    return 0;
+}
+
+void socket_table_init_chunk(uint32_t chunk)
+{
+    uint32_t i = 0;
+    uint32_t end = 0;
+    uint32_t off = 0;
+    uint32_t rem = 0;
+    uint32_t table_idx = 0;
+    uint32_t table_size = 0;
+    uint32_t client_ip = 0;
+    uint32_t server_ip = 0;
+    uint16_t client_port = 0;
+    uint16_t server_port = 0;
+    struct work_space *ws = g_work_space;
+    struct socket_table *st = &ws->socket_table;
+    struct socket_pool *sp = &st->socket_pool;
+
+    table_size = (uint32_t)st->client_port_num * st->server_ip_port_num;
+    table_idx = UINT32_MAX;
+    end = (chunk + 1) << SOCKET_CHUNK_SHIFT;
+    if (end > sp->num) {
+        end = sp->num;
+    }
+
+    for (i = chunk << SOCKET_CHUNK_SHIFT; i < end; i++) {
+        if ((i / table_size) != table_idx) {
+            table_idx = i / table_size;
+            client_ip = socket_table_client_ip(ws, table_idx);
+        }
+
+        /* see socket_port_table_get() */
+        off = i % table_size;
+        client_port = st->client_port_min + off / st->server_ip_port_num;
+        rem = off % st->server_ip_port_num;
+        server_port = st->server_port_min + rem / st->server_ip_num;
+        server_ip = st->server_ip_min + rem % st->server_ip_num;
+        socket_init(ws, socket_pool_get(st, i), client_ip, htons(client_port), htonl(server_ip), htons(server_port));
+    }
+
+    st->chunk_map[chunk >> 6] |= (1ul << (chunk & 63));
+}
+
+static bool socket_hash_slot_empty(struct socket_hash *hash, uint32_t bucket, int *slot)
+{
+    uint32_t hits = 0;
+
+    hits = socket_hash_bucket_match(&hash->buckets[bucket], 0);
+    if (hits) {
+        *slot = __builtin_ctz(hits) >> 1;
+        return true;
+    }
+
+    return false;
+}
+
+/* move one entry of a full bucket to its alternative bucket */
+static bool socket_hash_slot_displace(struct socket_hash *hash, uint32_t bucket, int *slot)
+{
+    int i = 0;
+    int slot2 = 0;
+    uint32_t alt = 0;
+    struct socket_hash_bucket *b = &hash->buckets[bucket];
+    struct socket_hash_bucket *b2 = NULL;
+
+    for (i = 0; i < SOCKET_HASH_BUCKET_SIZE; i++) {
+        alt = socket_hash_alt(hash, bucket, b->sig[i]);
+        if ((alt != bucket) && socket_hash_slot_empty(hash, alt, &slot2)) {
+            b2 = &hash->buckets[alt];
+            b2->sig[slot2] = b->sig[i];
+            b2->idx[slot2] = b->idx[i];
+            b->sig[i] = 0;
+            *slot = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool socket_hash_slot_free(struct socket_hash *hash, uint32_t b1, uint32_t b2, uint32_t *bucket, int *slot)
+{
+    if (socket_hash_slot_empty(hash, b1, slot) || socket_hash_slot_displace(hash, b1, slot)) {
+        *bucket = b1;
+        return true;
+    }
+
+    if (socket_hash_slot_empty(hash, b2, slot) || socket_hash_slot_displace(hash, b2, slot)) {
+        *bucket = b2;
+        return true;
+    }
+
+    return false;
+}
+
+/* reuse a closed socket */
+static bool socket_hash_slot_closed(struct socket_hash *hash, uint32_t bucket, int *slot)
+{
+    int i = 0;
+    struct socket_hash_bucket *b = &hash->buckets[bucket];
+
+    for (i = 0; i < SOCKET_HASH_BUCKET_SIZE; i++) {
+        if (b->sig[i] && (socket_hash_socket(hash, b->idx[i])->state == SK_CLOSED)) {
+            *slot = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* only the client side is a wildcard */
+static inline bool socket_hash_tuple_valid(const struct socket_table *st, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    uint16_t lport_host = ntohs(lport);
+    uint32_t laddr_host = ntohl(laddr);
+
+    return (fport != 0) && (laddr_host >= st->server_ip_min) && (laddr_host <= st->server_ip_max) &&
+        (lport_host >= st->server_port_min) && (lport_host <= st->server_port_max);
+}
+
+struct socket *socket_hash_insert(uint32_t h, uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    int slot = 0;
+    uint32_t bucket = 0;
+    uint32_t b1 = 0;
+    uint32_t b2 = 0;
+    uint16_t sig = 0;
+    struct socket *sk = NULL;
+    struct work_space *ws = g_work_space;
+    struct socket_table *st = &ws->socket_table;
+    struct socket_hash *hash = st->hash;
+    struct socket_hash_bucket *b = NULL;
+
+    if (!socket_hash_tuple_valid(st, laddr, fport, lport)) {
+        return NULL;
+    }
+
+    sig = socket_hash_sig(h);
+    b1 = h & hash->mask;
+    b2 = socket_hash_alt(hash, b1, sig);
+
+    if ((hash->next < hash->num) && socket_hash_slot_free(hash, b1, b2, &bucket, &slot)) {
+        sk = socket_hash_socket(hash, hash->next);
+        hash->buckets[bucket].idx[slot] = hash->next;
+        hash->next++;
+    } else if (socket_hash_slot_closed(hash, b1, &slot)) {
+        bucket = b1;
+    } else if (socket_hash_slot_closed(hash, b2, &slot)) {
+        bucket = b2;
+    } else {
+        net_stats_socket_error();
+        return NULL;
+    }
+
+    if (sk == NULL) {
+        sk = socket_hash_socket(hash, hash->buckets[bucket].idx[slot]);
+    }
+
+    b = &hash->buckets[bucket];
+    b->sig[slot] = sig;
+    socket_init(ws, sk, faddr, fport, laddr, lport);
+
+    return sk;
+}
+
+/* a fresh scratch socket for the tuple of a syn, it is never inserted */
+struct socket *socket_hash_syn_cookie(uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    struct work_space *ws = g_work_space;
+    struct socket_table *st = &ws->socket_table;
+    struct socket *sk = st->syn_cookie;
+
+    if (!socket_hash_tuple_valid(st, laddr, fport, lport)) {
+        return NULL;
+    }
+
+    socket_init(ws, sk, faddr, fport, laddr, lport);
+
+    return sk;
+}
+
+static int socket_table_init_hash(struct socket_table *st, bool syn_cookie)
+{
+    uint32_t seed = 0;
+    size_t size = 0;
+    uint32_t bucket_num = 1;
+    struct socket_hash *hash = NULL;
+    struct socket_pool *sp = &st->socket_pool;
+
+    /* load factor <= 50% */
+    while ((uint64_t)bucket_num * SOCKET_HASH_BUCKET_SIZE < (uint64_t)sp->num * 2) {
+        bucket_num <<= 1;
+    }
+
+    size = sizeof(struct socket_hash) + bucket_num * sizeof(struct socket_hash_bucket);
+    hash = (struct socket_hash *)rte_zmalloc_socket("socket_hash", size, CACHE_ALIGN_SIZE, rte_socket_id());
+    if (hash == NULL) {
+        printf("Error: socket hash allocation failed, memory size %0.2fMB\n", size * 1.0 / (1024 * 1024));
+        return -1;
     }
+
+    hash->mask = bucket_num - 1;
+    hash->num = sp->num;
+    hash->next = 0;
+    hash->sockets = sp->base;
+    hash->socket_shift = st->socket_shift;
+    st->hash = hash;
+
+    /* the last socket of the pool is kept for syn cookie replies */
+    if (syn_cookie) {
+        hash->num--;
+        st->syn_cookie = socket_hash_socket(hash, hash->num);
+        seed = (uint32_t)rte_rdtsc();
+        st->syn_cookie_secret = rand_r(&seed);
+    }
+
+    return 0;
+}
+
+/* the first packets don't wait for the whole table */
+static void socket_table_init_prefix(struct socket_table *st)
+{
+    uint32_t chunk = 0;
+
+    st->chunk_num = SOCKET_CHUNK_NUM(st->socket_pool.num);
+    st->chunk_pending = 1;
+    if (st->sparse) {
+        return;
+    }
+
+    for (chunk = 0; (chunk < st->chunk_num) && (chunk < SOCKET_CHUNK_PREFIX); chunk++) {
+        socket_table_init_chunk(chunk);
+    }
+    st->chunk_next = chunk;
+    st->chunk_tsc = rte_rdtsc();
 }
 
 int socket_table_init(struct work_space *ws)
@@ -191,23 +432,115 @@ int socket_table_init(struct work_space *ws)
         st->client_hop = 1;
     }
 
-    if (cfg->server) {
-        socket_port_table_init_ip_group(ws, st, &cfg->client_ip_group);
+    if (cfg->socket_table == SOCKET_TABLE_SPARSE) {
+        st->sparse = 1;
+    }
+
+    if (cfg->socket_table == SOCKET_TABLE_HASH) {
+        if (socket_table_init_hash(st, cfg->syn_cookie) < 0) {
+            return -1;
+        }
     } else {
-        socket_port_table_init_ip_range(ws, st, &(port->client_ip_range));
+        if (cfg->server) {
+            socket_port_table_init_ip_group(st, &cfg->client_ip_group);
+        } else {
+            socket_port_table_init_ip_range(st, &(port->client_ip_range));
+        }
+        socket_table_init_prefix(st);
     }
 
     st->socket_pool.next = 0;
     return 0;
 }
 
+/* dense: one chunk each tick, until all sockets are initialized */
+void socket_table_init_background(struct work_space *ws)
+{
+    uint32_t chunk = 0;
+    struct socket_table *st = &ws->socket_table;
+
+    for (chunk = st->chunk_next; chunk < st->chunk_num; chunk++) {
+        if ((st->chunk_map[chunk >> 6] & (1ul << (chunk & 63))) == 0) {
+            socket_table_init_chunk(chunk);
+            st->chunk_next = chunk + 1;
+            return;
+        }
+    }
+
+    st->chunk_next = chunk;
+    st->chunk_pending = 0;
+    printf("worker %d socket table initialized in the background, %0.3fs socket num %u\n", ws->id,
+        (rte_rdtsc() - st->chunk_tsc) * 1.0 / g_tsc_per_second, st->socket_pool.num);
+}
+
+/*
+ * client rss: each worker picks sockets whose client port is hashed to its queue.
+ * Index them once, instead of skipping the others at every launch.
+ * */
+int socket_table_init_rss(struct work_space *ws)
+{
+    uint32_t i = 0;
+    uint32_t num = 0;
+    uint32_t table_size = 0;
+    uint16_t client_port = 0;
+    struct socket_table *st = &ws->socket_table;
+    struct socket_pool *sp = &st->socket_pool;
+
+    /* see socket_port_table_get() */
+    table_size = (uint32_t)st->client_port_num * st->server_ip_port_num;
+    for (i = 0; i < sp->num; i++) {
+        client_port = st->client_port_min + (i % table_size) / st->server_ip_port_num;
+        if ((client_port % st->rss_num) == st->rss_id) {
+            num++;
+        }
+    }
+
+    if (num == 0) {
+        printf("Error: no client port for rss queue %u\n", st->rss_id);
+        return -1;
+    }
+
+    st->rss_index = (uint32_t *)rte_malloc_socket("rss_index", num * sizeof(uint32_t), CACHE_ALIGN_SIZE,
+        rte_socket_id());
+    if (st->rss_index == NULL) {
+        printf("Error: rss index allocation failed, socket num %u\n", num);
+        return -1;
+    }
+
+    num = 0;
+    for (i = 0; i < sp->num; i++) {
+        client_port = st->client_port_min + (i % table_size) / st->server_ip_port_num;
+        if ((client_port % st->rss_num) == st->rss_id) {
+            st->rss_index[num] = i;
+            num++;
+        }
+    }
+
+    st->rss_index_num = num;
+    sp->next = 0;
+    return 0;
+}
+
+void socket_table_close(struct work_space *ws)
+{
+    struct socket_table *st = &ws->socket_table;
+
+    if (st->rss_index) {
+        rte_free(st->rss_index);
+        st->rss_index = NULL;
+    }
+
+    if (st->hash) {
+        rte_free(st->hash);
+        st->hash = NULL;
+    }
+}
+
 void socket_disable_keepalive_random(void)
 {
-    struct socket_queue *sq = NULL;
     struct socket *sk = NULL;
 
-    sq = &g_keepalive_timer.queue;
-    sk = socket_queue_first(sq);
+    sk = socket_timer_first(&g_keepalive_timer);
     if (sk) {
         sk->keepalive = 0;
     }
@@ -27,6 +27,10 @@
 #include "tick.h"
 #include "net_stats.h"
 
+#include <rte_hash_crc.h>
+#include <rte_prefetch.h>
+#include <rte_vect.h>
+
 enum {
     SK_CLOSED,
     SK_LISTEN,
@@ -46,67 +50,160 @@ extern const char *g_sk_states[];
 #define RETRANSMIT_NUM_MAX          4
 #define REQUEST_INTERVAL_DEFAULT    (TSC_PER_SEC * 60)
 
+/*
+ * timer list node. Links are signed offsets to the next/prev node in
+ * SOCKET_NODE_ALIGN units, so a node is 8 bytes and a zeroed node is
+ * an empty list. Nodes must be SOCKET_NODE_ALIGN aligned.
+ * */
+#define SOCKET_NODE_SHIFT   5
+#define SOCKET_NODE_ALIGN   (1 << SOCKET_NODE_SHIFT)
+#define SOCKET_NODE_REACH   ((size_t)INT32_MAX << SOCKET_NODE_SHIFT)
+
 struct socket_node {
-    struct socket_node *next;
-    struct socket_node *prev;
+    int32_t next;
+    int32_t prev;
 };
 
-/* 64 bytes in a cache line */
+/*
+ * 64 bytes in a cache line.
+ * UDP only uses the first 32 bytes, two UDP sockets share a cache line.
+ * */
 struct socket {
     /* ------16 bytes------  */
     struct socket_node node;    /* must be first */
+    uint64_t timer_tsc;
 
     /* ------16 bytes------  */
-    uint32_t rcv_nxt;
-    uint32_t snd_nxt;
-    uint32_t snd_una;
-
+    uint32_t laddr;
+    uint32_t faddr;
+    uint16_t lport;
+    uint16_t fport;
+    union {
+        uint16_t csum_tcp;
+        uint16_t csum_udp;
+    };
     uint8_t flags; /* tcp flags*/
     uint8_t state:4;
     uint8_t retrans:3;
     uint8_t keepalive:1;
+
+    /* ------16 bytes------ TCP only */
+    uint32_t rcv_nxt;
+    uint32_t snd_nxt;
+    uint32_t snd_una;
     uint16_t log:1;
     uint16_t keepalive_request_num:15;
+    uint16_t csum_tcp_opt;
 
     /* ------16 bytes------  */
-    uint64_t timer_tsc;
     uint16_t csum_tcp_data;
     uint16_t csum_ip;
     uint16_t csum_ip_opt;
     uint16_t csum_ip_data;
+    uint32_t srtt;      /* adaptive rto, see socket_rtt_update() */
+    uint32_t rttvar;
+};
 
-    /* ------16 bytes------  */
-    uint32_t laddr;
-    uint32_t faddr;
-    uint16_t lport;
-    uint16_t fport;
-    union {
-        uint16_t csum_tcp;
-        uint16_t csum_udp;
-    };
-    uint16_t csum_tcp_opt;
+#define SOCKET_SHIFT_TCP    6
+#define SOCKET_SHIFT_UDP    5
 
 #ifdef HTTP_PARSE
-    /* ------16 bytes------  */
-    /* http protocol         */
+/*
+ * cold part of a tcp socket, in an array parallel to the socket pool,
+ * so that 'struct socket' stays in one cache line.
+ * */
+struct socket_cold {
+    /* http protocol */
     int64_t http_length;
     uint8_t http_parse_state;
     uint8_t http_flags;
-    uint8_t http_ack:1;
+    uint8_t ack_delay:1;    /* a delayed ack is pending, see tcp_ack_delay() */
     uint8_t http_frags:7;
     uint8_t snd_window;
+    uint8_t ack_segs;       /* segments not acked */
+    uint16_t http_done;     /* messages parsed, see http_parse_run() */
     uint32_t snd_max;
-#endif
+    /* sack: in recovery while snd_una is before snd_recover */
+    uint32_t snd_recover;
+    uint32_t snd_rexmit;    /* highest sequence retransmitted in this recovery */
+    /* congestion control, see tcp_cc.c */
+    uint16_t cwnd;
+    uint16_t ssthresh;
+    uint16_t cwnd_cnt;
+    uint16_t w_max;
+    uint32_t epoch_ms;
+    uint32_t k_ms;
+    uint32_t ts_recent;     /* TSval to echo, see tcp_ts_check() */
+    uint64_t ack_deadline;  /* of the last entry in the delayed ack fifo */
+    uint16_t reorder;       /* buffer of out-of-order segments, see tcp_reorder.h */
 };
+#endif
 
 struct socket_port_table {
-    struct socket sockets[0];
+    uint8_t sockets[0];
+};
+
+struct socket_queue {
+    struct socket_node head;
+} __attribute__((__aligned__(SOCKET_NODE_ALIGN)));
+
+/*
+ * hierarchical timing wheel, each level has 256 slots.
+ * A socket is in the slot of its deadline, the slots of an upper level are
+ * moved down (cascaded) when the lower level wraps around.
+ * */
+#define SOCKET_WHEEL_BITS   8
+#define SOCKET_WHEEL_SLOTS  (1 << SOCKET_WHEEL_BITS)
+#define SOCKET_WHEEL_MASK   (SOCKET_WHEEL_SLOTS - 1)
+#define SOCKET_WHEEL_LEVELS 4
+
+struct socket_timer {
+    uint64_t now;   /* the next wheel tick to expire */
+    uint8_t shift;  /* wheel tick = tsc >> shift */
+    struct socket_queue expired;
+    struct socket_queue cascade;
+    struct socket_queue slots[SOCKET_WHEEL_LEVELS][SOCKET_WHEEL_SLOTS];
+};
+
+struct socket_cold;
+struct udp_seq_flow;
+
+/*
+ * sockets are initialized in chunks on first touch.
+ * dense: a prefix is initialized at startup, the rest in the background.
+ * sparse: untouched chunks are never faulted in.
+ * */
+#define SOCKET_CHUNK_PREFIX 16
+#define SOCKET_CHUNK_SHIFT  12
+#define SOCKET_CHUNK_SIZE   (1u << SOCKET_CHUNK_SHIFT)
+#define SOCKET_CHUNK_NUM(n) (((n) + SOCKET_CHUNK_SIZE - 1) >> SOCKET_CHUNK_SHIFT)
+#define SOCKET_CHUNK_MAP_SIZE(n) (((SOCKET_CHUNK_NUM(n) + 63) / 64) * sizeof(uint64_t))
+
+/*
+ * hash socket table: cuckoo hash keyed on the tuple, for clients that are not
+ * in dense ranges (eg behind SNAT). A bucket has 8 slots of 16-bit signatures
+ * compared at once; signature 0 marks an empty slot.
+ * */
+#define SOCKET_HASH_BUCKET_SIZE 8
+
+struct socket_hash_bucket {
+    uint16_t sig[SOCKET_HASH_BUCKET_SIZE];
+    uint32_t idx[SOCKET_HASH_BUCKET_SIZE];
+} __attribute__((__aligned__(CACHE_ALIGN_SIZE)));
+
+struct socket_hash {
+    uint32_t mask;      /* bucket num - 1 */
+    uint32_t num;       /* sockets */
+    uint32_t next;      /* next unused socket */
+    uint8_t socket_shift;
+    uint8_t *sockets;
+    struct socket_hash_bucket buckets[0];
 };
 
 struct socket_pool {
     uint32_t num;
     uint32_t next;
-    struct socket base[0] __attribute__((__aligned__(CACHE_ALIGN_SIZE)));
+    uint8_t base[0] __attribute__((__aligned__(CACHE_ALIGN_SIZE)));
 };
 
 struct socket_table {
@@ -128,45 +225,106 @@ struct socket_table {
     uint8_t rss;
     uint8_t rss_id;
     uint8_t rss_num;
+    uint8_t sparse;
+    uint8_t chunk_pending; /* some chunks are not initialized */
+    uint8_t socket_shift; /* SOCKET_SHIFT_TCP or SOCKET_SHIFT_UDP */
+    uint32_t chunk_num;
+    uint32_t chunk_next; /* dense: next chunk to initialize in the background */
+    uint64_t chunk_tsc;  /* dense: background initialization start */
+    uint32_t rss_index_num;
+    uint32_t *rss_index; /* client rss: sockets of this queue */
+    uint64_t *chunk_map; /* bitmap of initialized chunks */
+    uint64_t *timer_deadline; /* of each socket, kept for cascading, see socket_add_timer() */
+    struct socket_hash *hash;
+    struct socket *syn_cookie;  /* hash: syns are answered from this socket, see tcp_syn_cookie_reply() */
+    uint32_t syn_cookie_secret;
+    struct socket_cold *cold;
+    struct udp_seq_flow *udp_seq;   /* 'udp_seq': the cold part of udp sockets */
     struct socket_table *socket_table_hash[256]; /* server rss hash */
                      /* [client-ip][client-port][server-port][server-ip] */
     struct socket_port_table *ht[NETWORK_PORT_NUM];
     struct socket_pool socket_pool;
 };
 
+static inline struct socket_node *socket_node_next(struct socket_node *sn)
+{
+    return (struct socket_node *)((uint8_t *)sn + (int64_t)sn->next * SOCKET_NODE_ALIGN);
+}
+
+static inline struct socket_node *socket_node_prev(struct socket_node *sn)
+{
+    return (struct socket_node *)((uint8_t *)sn + (int64_t)sn->prev * SOCKET_NODE_ALIGN);
+}
+
+static inline int32_t socket_node_offset(const struct socket_node *from, const struct socket_node *to)
+{
+    return (int32_t)(((const uint8_t *)to - (const uint8_t *)from) / SOCKET_NODE_ALIGN);
+}
+
 static inline void socket_node_init(struct socket_node *sn)
 {
-    sn->next = sn;
-    sn->prev = sn;
+    sn->next = 0;
+    sn->prev = 0;
 }
 
 static inline void socket_node_del(struct socket_node *sn)
 {
-    struct socket_node *prev = sn->prev;
-    struct socket_node *next = sn->next;
+    struct socket_node *prev = socket_node_prev(sn);
+    struct socket_node *next = socket_node_next(sn);
 
     if (sn != next) {
-        prev->next = next;
-        next->prev = prev;
+        prev->next = socket_node_offset(prev, next);
+        next->prev = socket_node_offset(next, prev);
         socket_node_init(sn);
     }
 }
 
+/* the pool stride depends on the protocol */
+static inline struct socket *socket_pool_get(const struct socket_table *st, uint32_t idx)
+{
+    return (struct socket *)(st->socket_pool.base + ((size_t)idx << st->socket_shift));
+}
+
+static inline uint32_t socket_pool_index(const struct socket_table *st, const struct socket *sk)
+{
+    return ((const uint8_t *)sk - st->socket_pool.base) >> st->socket_shift;
+}
+
+void socket_table_init_chunk(uint32_t chunk);
+
+static inline bool socket_table_chunk_ready(const struct socket_table *st, const struct socket *sk)
+{
+    uint32_t chunk = socket_pool_index(st, sk) >> SOCKET_CHUNK_SHIFT;
+
+    return (st->chunk_map[chunk >> 6] & (1ul << (chunk & 63))) != 0;
+}
+
+/* only for the table of this worker */
+static inline void socket_table_touch(const struct socket_table *st, const struct socket *sk)
+{
+    if (unlikely(!socket_table_chunk_ready(st, sk))) {
+        socket_table_init_chunk(socket_pool_index(st, sk) >> SOCKET_CHUNK_SHIFT);
+    }
+}
+
+/* sp->next is a cursor of rss_index */
 static inline struct socket *socket_table_get_socket_rss(struct socket_table *st)
 {
     struct socket *sk = NULL;
     struct socket_pool *sp = &st->socket_pool;
 
     while (1) {
-        sk = &(sp->base[sp->next]);
+        sk = socket_pool_get(st, st->rss_index[sp->next]);
+        if (unlikely(st->chunk_pending)) {
+            socket_table_touch(st, sk);
+        }
         sp->next++;
-        /* 1. each worker picks sockets in port order
-         * 2. avoid incorrectly hashed sockets
-         * */
-        if (((ntohs(sk->lport) % st->rss_num) != st->rss_id) || (sk->laddr == 0)) {
-            if (sp->next >= sp->num) {
-                sp->next = 0;
-            }
+        if (sp->next >= st->rss_index_num) {
+            sp->next = 0;
+        }
+
+        /* taken over by another worker, see socket_client_check_rss() */
+        if (unlikely(sk->laddr == 0)) {
             continue;
         }
         break;
@@ -177,22 +335,28 @@ static inline struct socket *socket_table_get_socket_rss(struct socket_table *st
 
 static inline struct socket *socket_table_get_socket(struct socket_table *st)
 {
+    uint32_t num = 0;
     struct socket *sk = NULL;
     struct socket_pool *sp = &st->socket_pool;
 
     if (st->rss == false) {
-        sk = &(sp->base[sp->next]);
+        num = sp->num;
+        sk = socket_pool_get(st, sp->next);
+        if (unlikely(st->chunk_pending)) {
+            socket_table_touch(st, sk);
+        }
         sp->next++;
-        if (sp->next >= sp->num) {
+        if (sp->next >= num) {
             sp->next = 0;
         }
     } else {
+        num = st->rss_index_num;
         sk = socket_table_get_socket_rss(st);
     }
 
     if (st->client_hop) {
         sp->next += 65535;
-        if (sp->next >= sp->num) {
+        if (sp->next >= num) {
             sp->next = 0;
         }
     }
@@ -207,7 +371,7 @@ static inline struct socket *socket_port_table_get(const struct socket_table *st
 
     idx = (client_port_host - st->client_port_min) * st->server_ip_port_num +
         (server_port_host - st->server_port_min) * st->server_ip_num + (server_ip_host - st->server_ip_min);
-    return &t->sockets[idx];
+    return (struct socket *)(t->sockets + ((size_t)idx << st->socket_shift));
 }
 
 static inline struct socket *socket_common_lookup(const struct socket_table *st, uint32_t client_ip, uint32_t server_ip
@@ -229,6 +393,111 @@ static inline struct socket *socket_common_lookup(const struct socket_table *st,
     return NULL;
 }
 
+static inline uint32_t socket_hash_tuple(uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    uint64_t addr = ((uint64_t)faddr << 32) | laddr;
+    uint32_t port = ((uint32_t)fport << 16) | lport;
+
+    return rte_hash_crc_4byte(port, rte_hash_crc_8byte(addr, 0));
+}
+
+static inline uint16_t socket_hash_sig(uint32_t hash)
+{
+    return (uint16_t)(hash >> 16) | 1;
+}
+
+/* the alternative bucket only depends on the bucket and signature, so entries can be moved */
+static inline uint32_t socket_hash_alt(const struct socket_hash *hash, uint32_t bucket, uint16_t sig)
+{
+    return (bucket ^ ((uint32_t)sig * 0x5bd1e995)) & hash->mask;
+}
+
+static inline struct socket *socket_hash_socket(const struct socket_hash *hash, uint32_t idx)
+{
+    return (struct socket *)(hash->sockets + ((size_t)idx << hash->socket_shift));
+}
+
+/* two bits per matched slot */
+static inline uint32_t socket_hash_bucket_match(const struct socket_hash_bucket *b, uint16_t sig)
+{
+#ifdef __SSE2__
+    __m128i sigs = _mm_load_si128((const __m128i *)b->sig);
+    __m128i key = _mm_set1_epi16(sig);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(sigs, key)) & 0x5555;
+#else
+    int i = 0;
+    uint32_t hits = 0;
+
+    for (i = 0; i < SOCKET_HASH_BUCKET_SIZE; i++) {
+        if (b->sig[i] == sig) {
+            hits |= 1u << (i * 2);
+        }
+    }
+
+    return hits;
+#endif
+}
+
+static inline struct socket *socket_hash_bucket_lookup(const struct socket_hash *hash,
+    const struct socket_hash_bucket *b, uint16_t sig, uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    uint32_t hits = 0;
+    struct socket *sk = NULL;
+
+    hits = socket_hash_bucket_match(b, sig);
+    while (hits) {
+        sk = socket_hash_socket(hash, b->idx[__builtin_ctz(hits) >> 1]);
+        if ((sk->faddr == faddr) && (sk->laddr == laddr) && (sk->fport == fport) && (sk->lport == lport)) {
+            return sk;
+        }
+        hits &= hits - 1;
+    }
+
+    return NULL;
+}
+
+static inline struct socket *socket_hash_lookup(const struct socket_hash *hash, uint32_t h,
+    uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport)
+{
+    uint16_t sig = socket_hash_sig(h);
+    uint32_t b1 = h & hash->mask;
+    uint32_t b2 = socket_hash_alt(hash, b1, sig);
+    struct socket *sk = NULL;
+
+    rte_prefetch0(&hash->buckets[b2]);
+    sk = socket_hash_bucket_lookup(hash, &hash->buckets[b1], sig, faddr, laddr, fport, lport);
+    if (sk == NULL) {
+        sk = socket_hash_bucket_lookup(hash, &hash->buckets[b2], sig, faddr, laddr, fport, lport);
+    }
+
+    return sk;
+}
+
+struct socket *socket_hash_insert(uint32_t h, uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport);
+struct socket *socket_hash_syn_cookie(uint32_t faddr, uint32_t laddr, uint16_t fport, uint16_t lport);
+
+/* UDP packets and TCP SYNs create sockets, with syn cookies only the handshake acks do */
+static inline struct socket *socket_hash_server_lookup(const struct socket_table *st, const struct iphdr *iph,
+    const struct tcphdr *th, uint32_t saddr, uint32_t daddr)
+{
+    uint32_t h = 0;
+    struct socket *sk = NULL;
+
+    h = socket_hash_tuple(saddr, daddr, th->th_sport, th->th_dport);
+    sk = socket_hash_lookup(st->hash, h, saddr, daddr, th->th_sport, th->th_dport);
+    if (likely(sk != NULL)) {
+        return sk;
+    }
+
+    if ((iph->protocol == IPPROTO_UDP) ||
+        ((st->syn_cookie == NULL) && ((th->th_flags & (TH_SYN | TH_ACK | TH_RST)) == TH_SYN))) {
+        return socket_hash_insert(h, saddr, daddr, th->th_sport, th->th_dport);
+    }
+
+    return NULL;
+}
+
 static inline void socket_dup(struct socket *dst, struct socket *src)
 {
     /*
@@ -264,6 +533,11 @@ static inline void socket_client_check_rss(const struct socket_table *st,
         }
 
         sk2 = socket_common_lookup(st2, daddr, saddr, dport, sport);
+        /* the other worker has not opened a socket in a chunk it has not initialized */
+        if (sk2 && unlikely(st2->chunk_pending) && !socket_table_chunk_ready(st2, sk2)) {
+            return;
+        }
+
         if (sk2 && (sk2->laddr == daddr) && (sk2->faddr == saddr)) {
             socket_dup(sk, sk2);
             sk2->laddr = 0;
@@ -281,6 +555,10 @@ static inline struct socket *socket_client_lookup(const struct socket_table *st,
 
     ip_hdr_get_addr_low32(iph, saddr, daddr);
     sk = socket_common_lookup(st, daddr, saddr, th->th_dport, th->th_sport);
+    if (sk && unlikely(st->chunk_pending)) {
+        socket_table_touch(st, sk);
+    }
+
     if (sk && (sk->laddr == daddr) && (sk->faddr == saddr)) {
         if (st->rss) {
             socket_client_check_rss(st, daddr, saddr, th->th_dport, th->th_sport, sk);
@@ -299,7 +577,15 @@ static inline struct socket *socket_server_lookup(const struct socket_table *st,
     struct socket *sk = NULL;
 
     ip_hdr_get_addr_low32(iph, saddr, daddr);
+    if (unlikely(st->hash != NULL)) {
+        return socket_hash_server_lookup(st, iph, th, saddr, daddr);
+    }
+
     sk = socket_common_lookup(st, saddr, daddr, th->th_sport, th->th_dport);
+    if (sk && unlikely(st->chunk_pending)) {
+        socket_table_touch(st, sk);
+    }
+
     if (sk && (sk->laddr == daddr) && (sk->faddr == saddr)) {
         return sk;
     }
@@ -318,30 +604,36 @@ static inline void socket_close(struct socket *sk)
 }
 
 #ifdef HTTP_PARSE
-static inline void socket_init_http(struct socket *sk)
+static inline struct socket_cold *socket_cold_get(const struct socket_table *st, const struct socket *sk)
 {
-    sk->http_length = 0;
-    sk->http_parse_state = 0;
-    sk->http_flags = 0;
-    sk->http_ack = 0;
-    sk->http_frags = 0;
+    return &st->cold[socket_pool_index(st, sk)];
 }
 
-static inline void socket_init_http_server(struct socket *sk, uint32_t payload_size)
+static inline void socket_init_http(struct socket_cold *skc)
 {
-    sk->http_length = 0;
-    sk->http_parse_state = 0;
-    sk->http_flags = 0;
-    sk->http_ack = 0;
-    sk->snd_max = sk->snd_nxt + payload_size;
+    skc->http_length = 0;
+    skc->http_parse_state = 0;
+    skc->http_flags = 0;
+    skc->http_frags = 0;
+    skc->http_done = 0;
+}
+
+static inline void socket_init_http_server(struct socket *sk, struct socket_cold *skc, uint32_t payload_size)
+{
+    skc->http_length = 0;
+    skc->http_parse_state = 0;
+    skc->http_flags = 0;
+    skc->snd_max = sk->snd_nxt + payload_size;
+    skc->snd_recover = sk->snd_nxt;
+    skc->snd_rexmit = sk->snd_nxt;
 }
 
 #else
-#define socket_init_http(sk) do{}while(0)
-#define socket_init_http_server(sk, payload_size) do{}while(0)
+#define socket_init_http(skc) do{}while(0)
+#define socket_init_http_server(sk, skc, payload_size) do{}while(0)
 #endif
 
-static inline void socket_server_open(__rte_unused struct socket_table *st, struct socket *sk, struct tcphdr *th)
+static inline void socket_server_open(__rte_unused const struct socket_table *st, struct socket *sk, struct tcphdr *th)
 {
     if (sk->state != SK_SYN_RECEIVED) {
         sk->state = SK_SYN_RECEIVED;
@@ -354,10 +646,15 @@ static inline void socket_server_open(__rte_unused struct socket_table *st, stru
 #endif
     sk->retrans = 0;
     sk->keepalive_request_num = 0;
+    sk->srtt = 0;
+    sk->rttvar = 0;
     sk->snd_nxt++;
     sk->snd_una = sk->snd_nxt;
 #ifdef HTTP_PARSE
-    sk->snd_window = 1;
+    socket_init_http(socket_cold_get(st, sk));
+    socket_cold_get(st, sk)->snd_window = 1;
+    socket_cold_get(st, sk)->ack_delay = 0;
+    socket_cold_get(st, sk)->ts_recent = 0;
 #endif
     sk->rcv_nxt = ntohl(th->th_seq) + 1;
 }
@@ -375,12 +672,36 @@ static inline struct socket *socket_client_open(struct socket_table *st, uint64_
         sk->retrans = 0;
         sk->keepalive_request_num = 0;
         sk->keepalive = g_config.keepalive;
+        sk->srtt = 0;
+        sk->rttvar = 0;
         sk->snd_nxt++;
         sk->snd_una = sk->snd_nxt;
         sk->rcv_nxt = 0;
         sk->state = SK_SYN_SENT;
         net_stats_socket_open();
-        socket_init_http(sk);
+#ifdef HTTP_PARSE
+        socket_init_http(socket_cold_get(st, sk));
+        socket_cold_get(st, sk)->ack_delay = 0;
+        socket_cold_get(st, sk)->ts_recent = 0;
+#endif
+        return sk;
+    } else {
+        return NULL;
+    }
+}
+
+/* only touch the first 32 bytes */
+static inline struct socket *socket_client_open_udp(struct socket_table *st, uint64_t now_tsc)
+{
+    struct socket *sk = NULL;
+
+    sk = socket_table_get_socket(st);
+    if (sk->state == SK_CLOSED) {
+        sk->timer_tsc = now_tsc;
+        sk->retrans = 0;
+        sk->keepalive = g_config.keepalive;
+        sk->state = SK_SYN_SENT;
+        net_stats_socket_open();
         return sk;
     } else {
         return NULL;
@@ -390,6 +711,9 @@ static inline struct socket *socket_client_open(struct socket_table *st, uint64_
 void socket_log(struct socket *sk, const char *tag);
 void socket_print(struct socket *sk, const char *tag);
 int socket_table_init(struct work_space *ws);
+int socket_table_init_rss(struct work_space *ws);
+void socket_table_init_background(struct work_space *ws);
+void socket_table_close(struct work_space *ws);
 void socket_disable_keepalive_random(void);
 #ifdef DPERF_DEBUG
 #define SOCKET_LOG(sk, tag) socket_log(sk, tag)
@@ -18,15 +18,79 @@
 
 #include "socket_timer.h"
 
-__thread struct socket_timer g_retransmit_timer;
-__thread struct socket_timer g_keepalive_timer; /* client only */
-__thread struct socket_timer g_timeout_timer;
+static void socket_timer_init_wheel(struct socket_timer *timer)
+{
+    int i = 0;
+    int j = 0;
+    int ticks_per_sec = g_config.ticks_per_sec;
+    uint64_t tick_tsc = 0;
+
+    if (ticks_per_sec == 0) {
+        ticks_per_sec = TICKS_PER_SEC_DEFAULT;
+    }
+    tick_tsc = g_tsc_per_second / ticks_per_sec;
+
+    /* not coarser than a loop tick */
+    timer->shift = 0;
+    while ((2ul << timer->shift) <= tick_tsc) {
+        timer->shift++;
+    }
+
+    timer->now = rte_rdtsc() >> timer->shift;
+    socket_queue_init(&timer->expired);
+    socket_queue_init(&timer->cascade);
+    for (i = 0; i < SOCKET_WHEEL_LEVELS; i++) {
+        for (j = 0; j < SOCKET_WHEEL_SLOTS; j++) {
+            socket_queue_init(&timer->slots[i][j]);
+        }
+    }
+}
 
 void socket_timer_init(void)
 {
-    socket_queue_init(&g_retransmit_timer.queue);
-    socket_queue_init(&g_keepalive_timer.queue);
-    socket_queue_init(&g_timeout_timer.queue);
+    socket_timer_init_wheel(&g_retransmit_timer);
+    socket_timer_init_wheel(&g_keepalive_timer);
+    socket_timer_init_wheel(&g_timeout_timer);
+}
+
+/* level 0 wraps around at timer->now, move the due slots of upper levels down */
+void socket_timer_cascade(struct socket_timer *timer)
+{
+    int level = 0;
+    uint64_t slot = 0;
+    struct socket *sk = NULL;
+    struct socket_queue *cascade = &timer->cascade;
+
+    for (level = 1; level < SOCKET_WHEEL_LEVELS; level++) {
+        slot = (timer->now >> (level * SOCKET_WHEEL_BITS)) & SOCKET_WHEEL_MASK;
+        socket_queue_splice(cascade, &timer->slots[level][slot]);
+        if (slot != 0) {
+            break;
+        }
+    }
+
+    while ((sk = socket_queue_first(cascade)) != NULL) {
+        socket_del_timer(sk);
+        socket_timer_insert(timer, sk, *socket_timer_deadline(sk));
+    }
+}
+
+struct socket *socket_timer_first(struct socket_timer *timer)
+{
+    int i = 0;
+    int j = 0;
+    struct socket *sk = NULL;
+
+    for (i = 0; i < SOCKET_WHEEL_LEVELS; i++) {
+        for (j = 0; j < SOCKET_WHEEL_SLOTS; j++) {
+            sk = socket_queue_first(&timer->slots[i][j]);
+            if (sk) {
+                return sk;
+            }
+        }
+    }
+
+    return NULL;
 }
 
 static inline void socket_timeout_handler(__rte_unused struct work_space *ws, struct socket *sk)
@@ -35,12 +99,8 @@ static inline void socket_timeout_handler(__rte_unused struct work_space *ws, st
     socket_close(sk);
 }
 
+/* runs once a second, so it drains all expired sockets */
 void socket_timeout_timer_expire(struct work_space *ws)
 {
-    uint64_t timeout_tsc = 0;
-    struct socket_timer *timer = NULL;
-
-    timer = &g_timeout_timer;
-    timeout_tsc = (g_config.retransmit_timeout * RETRANSMIT_NUM_MAX) + g_config.keepalive_request_interval;
-    socket_timer_run(ws, timer, timeout_tsc, socket_timeout_handler);
+    socket_timer_run(ws, &g_timeout_timer, socket_timeout_handler, UINT32_MAX);
 }
@@ -24,20 +24,13 @@
 #include "socket.h"
 #include "work_space.h"
 
-extern __thread struct socket_timer g_retransmit_timer;
-extern __thread struct socket_timer g_keepalive_timer;
-extern __thread struct socket_timer g_timeout_timer;
+/* the heads live in the work space, within reach of the socket node offsets */
+#define g_retransmit_timer  (g_work_space->retransmit_timer)
+#define g_keepalive_timer   (g_work_space->keepalive_timer)
+#define g_timeout_timer     (g_work_space->timeout_timer)
 
 typedef void(*socket_timer_handler_t)(struct work_space *, struct socket *);
 
-struct socket_queue {
-    struct socket_node head;
-};
-
-struct socket_timer {
-    struct socket_queue queue;
-};
-
 static inline void socket_queue_init(struct socket_queue *sq)
 {
     socket_node_init(&sq->head);
@@ -54,42 +47,195 @@ static inline void socket_queue_push(struct socket_queue *sq, struct socket *sk)
     struct socket_node *head = &sq->head;
     struct socket_node *sn = &(sk->node);
     struct socket_node *next = head;
-    struct socket_node *prev = next->prev;
+    struct socket_node *prev = socket_node_prev(head);
 
     /* [head->prev] [new-node] [head]  */
-    sn->next = next;
-    sn->prev = prev;
-    next->prev = sn;
-    prev->next = sn;
+    sn->next = socket_node_offset(sn, next);
+    sn->prev = socket_node_offset(sn, prev);
+    next->prev = socket_node_offset(next, sn);
+    prev->next = socket_node_offset(prev, sn);
 }
 
 static inline struct socket *socket_queue_first(struct socket_queue *sq)
 {
     struct socket_node *head = &sq->head;
 
-    if (head->next != head) {
-        return (struct socket *)(head->next);
+    if (head->next != 0) {
+        return (struct socket *)socket_node_next(head);
     }
 
     return NULL;
 }
 
+/* move all sockets of src to the tail of dst */
+static inline void socket_queue_splice(struct socket_queue *dst, struct socket_queue *src)
+{
+    struct socket_node *head = &src->head;
+    struct socket_node *dhead = &dst->head;
+    struct socket_node *first = NULL;
+    struct socket_node *last = NULL;
+    struct socket_node *dlast = NULL;
+
+    if (head->next == 0) {
+        return;
+    }
+
+    first = socket_node_next(head);
+    last = socket_node_prev(head);
+    dlast = socket_node_prev(dhead);
+
+    dlast->next = socket_node_offset(dlast, first);
+    first->prev = socket_node_offset(first, dlast);
+    last->next = socket_node_offset(last, dhead);
+    dhead->prev = socket_node_offset(dhead, last);
+    socket_node_init(head);
+}
+
 static inline void socket_del_timer(struct socket *sk)
 {
     socket_queue_del(sk);
 }
 
-static inline void socket_add_timer(struct socket_queue *head, struct socket *sk, uint64_t now_tsc)
+/*
+ * RFC 6298, in units of (1 << SOCKET_RTT_SHIFT) tsc.
+ * srtt is scaled by 8 and rttvar by 4, srtt 0 means no sample yet.
+ * */
+#define SOCKET_RTT_SHIFT    10
+
+static inline void socket_rtt_update(uint32_t *srtt, uint32_t *rttvar, uint32_t rtt)
+{
+    int32_t delta = 0;
+
+    if (rtt == 0) {
+        rtt = 1;
+    }
+
+    if (*srtt == 0) {
+        *srtt = rtt << 3;
+        *rttvar = rtt << 1;
+        return;
+    }
+
+    delta = (int32_t)rtt - (int32_t)(*srtt >> 3);
+    *srtt += delta;
+    if (delta < 0) {
+        delta = -delta;
+    }
+    *rttvar += delta - (*rttvar >> 2);
+}
+
+static inline void socket_rtt_add(struct work_space *ws, struct socket *sk, uint32_t rtt)
+{
+    socket_rtt_update(&sk->srtt, &sk->rttvar, rtt);
+    socket_rtt_update(&ws->srtt, &ws->rttvar, rtt);
+}
+
+/* Karn: callers don't sample retransmitted segments */
+static inline void socket_rtt_sample(struct work_space *ws, struct socket *sk, uint64_t now_tsc)
+{
+    socket_rtt_add(ws, sk, (now_tsc - sk->timer_tsc) >> SOCKET_RTT_SHIFT);
+}
+
+/* exponential backoff by sk->retrans, never slower than retransmit_timeout */
+static inline uint64_t socket_rto(const struct socket *sk)
+{
+    uint32_t srtt = sk->srtt;
+    uint32_t rttvar = sk->rttvar;
+    uint64_t rto = 0;
+
+    if (srtt == 0) {
+        srtt = g_work_space->srtt;
+        rttvar = g_work_space->rttvar;
+        if (srtt == 0) {
+            return g_config.retransmit_timeout;
+        }
+    }
+
+    rto = (uint64_t)((srtt >> 3) + (rttvar ? rttvar : 1)) << SOCKET_RTT_SHIFT;
+    if (rto < g_config.rto_min) {
+        rto = g_config.rto_min;
+    }
+
+    rto <<= sk->retrans;
+    if (rto > g_config.retransmit_timeout) {
+        rto = g_config.retransmit_timeout;
+    }
+
+    return rto;
+}
+
+static inline uint64_t socket_retransmit_timeout(const struct socket *sk)
+{
+    uint64_t timeout = g_config.retransmit_timeout;
+
+    if (g_config.adaptive_rto) {
+        timeout = socket_rto(sk);
+    }
+
+    /* server delays sending by 0.1s to avoid simultaneous retransmission */
+    if (g_config.server) {
+        timeout += timeout / 10;
+    }
+
+    return timeout;
+}
+
+static inline uint64_t socket_keepalive_timeout(__rte_unused const struct socket *sk)
+{
+    return g_config.keepalive_request_interval;
+}
+
+static inline uint64_t socket_timeout_timeout(__rte_unused const struct socket *sk)
+{
+    return (g_config.retransmit_timeout * RETRANSMIT_NUM_MAX) + g_config.keepalive_request_interval;
+}
+
+/* never expires before the deadline */
+static inline void socket_timer_insert(struct socket_timer *timer, struct socket *sk, uint64_t deadline_tsc)
+{
+    int level = 0;
+    uint64_t delta = 0;
+    uint64_t slot = 0;
+    uint64_t tick = (deadline_tsc + (1ul << timer->shift) - 1) >> timer->shift;
+
+    if (tick < timer->now) {
+        tick = timer->now;
+    }
+
+    delta = tick - timer->now;
+    while ((delta >= SOCKET_WHEEL_SLOTS) && (level < (SOCKET_WHEEL_LEVELS - 1))) {
+        delta >>= SOCKET_WHEEL_BITS;
+        level++;
+    }
+
+    if (unlikely(delta >= SOCKET_WHEEL_SLOTS)) {
+        tick = timer->now + (1ul << (SOCKET_WHEEL_BITS * SOCKET_WHEEL_LEVELS)) - 1;
+    }
+
+    slot = (tick >> (level * SOCKET_WHEEL_BITS)) & SOCKET_WHEEL_MASK;
+    socket_queue_push(&timer->slots[level][slot], sk);
+}
+
+static inline uint64_t *socket_timer_deadline(const struct socket *sk)
+{
+    struct socket_table *st = &g_work_space->socket_table;
+
+    return &st->timer_deadline[socket_pool_index(st, sk)];
+}
+
+/* the timeout may change while the socket waits, so the deadline is kept */
+static inline void socket_add_timer(struct socket_timer *timer, struct socket *sk, uint64_t now_tsc,
+    uint64_t timeout)
 {
     sk->timer_tsc = now_tsc;
+    *socket_timer_deadline(sk) = now_tsc + timeout;
     socket_queue_del(sk);
-    socket_queue_push(head, sk);
+    socket_timer_insert(timer, sk, now_tsc + timeout);
 }
 
 static inline void socket_start_timeout_timer(struct socket *sk, uint64_t now_tsc)
 {
-    struct socket_queue *queue = &g_timeout_timer.queue;
-    socket_add_timer(queue, sk, now_tsc);
+    socket_add_timer(&g_timeout_timer, sk, now_tsc, socket_timeout_timeout(sk));
 }
 
 static inline void socket_stop_timeout_timer(struct socket *sk)
@@ -114,20 +260,25 @@ static inline uint64_t socket_accurate_timer_tsc(struct socket *sk, uint64_t now
     }
 }
 
-static inline void socket_start_keepalive_timer(struct socket *sk, uint64_t now_tsc)
+/* UDP: no sequences */
+static inline void socket_start_keepalive_timer_force(struct socket *sk, uint64_t now_tsc)
 {
-    struct socket_queue *queue = &g_keepalive_timer.queue;
-
-    if (sk->keepalive && (sk->snd_nxt == sk->snd_una)) {
+    if (sk->keepalive) {
         now_tsc = socket_accurate_timer_tsc(sk, now_tsc);
-        socket_add_timer(queue, sk, now_tsc);
+        socket_add_timer(&g_keepalive_timer, sk, now_tsc, socket_keepalive_timeout(sk));
+    }
+}
+
+static inline void socket_start_keepalive_timer(struct socket *sk, uint64_t now_tsc)
+{
+    if (sk->snd_nxt == sk->snd_una) {
+        socket_start_keepalive_timer_force(sk, now_tsc);
     }
 }
 
 static inline void socket_start_retransmit_timer_force(struct socket *sk, uint64_t now_tsc)
 {
-    struct socket_queue *queue = &g_retransmit_timer.queue;
-    socket_add_timer(queue, sk, now_tsc);
+    socket_add_timer(&g_retransmit_timer, sk, now_tsc, socket_retransmit_timeout(sk));
 }
 
 static inline void socket_start_retransmit_timer(struct socket *sk, uint64_t now_tsc)
@@ -145,23 +296,66 @@ static inline void socket_stop_retransmit_timer(__rte_unused struct socket *sk)
     }
 }
 
-static inline void socket_timer_run(struct work_space *ws, struct socket_timer *st, uint64_t timeout,
-    socket_timer_handler_t handler)
+void socket_timer_cascade(struct socket_timer *timer);
+
+/*
+ * Expired sockets are unlinked in batches and prefetched before the handlers run.
+ * At most 'budget' sockets run per call, the rest stay on the expired list for the
+ * next loop, so an expiry storm can't starve rx.
+ * */
+#define SOCKET_TIMER_BATCH  16
+#define SOCKET_TIMER_BUDGET 1024
+
+static inline int socket_timer_pop(struct socket_queue *expired, struct socket **sks)
 {
-    struct socket *sk = NULL;
-    struct socket_queue *sq = &(st->queue);
-    uint64_t now_tsc = work_space_tsc(ws);
+    int i = 0;
+    struct socket_node *head = &expired->head;
+    struct socket_node *sn = socket_node_next(head);
+    struct socket_node *next = NULL;
+
+    /* an empty queue points to itself */
+    while ((sn != head) && (i < SOCKET_TIMER_BATCH)) {
+        next = socket_node_next(sn);
+        rte_prefetch0(next);
+        sks[i++] = (struct socket *)sn;
+        sn = next;
+    }
+
+    return i;
+}
+
+/* move the due slots to the expired list, then run them */
+static inline void socket_timer_run(struct work_space *ws, struct socket_timer *timer,
+    socket_timer_handler_t handler, uint32_t budget)
+{
+    int i = 0;
+    int num = 0;
+    uint32_t done = 0;
+    struct socket *sks[SOCKET_TIMER_BATCH];
+    struct socket_queue *expired = &timer->expired;
+    uint64_t tick = work_space_tsc(ws) >> timer->shift;
+
+    while (timer->now <= tick) {
+        if (unlikely((timer->now & SOCKET_WHEEL_MASK) == 0)) {
+            socket_timer_cascade(timer);
+        }
+        socket_queue_splice(expired, &timer->slots[0][timer->now & SOCKET_WHEEL_MASK]);
+        timer->now++;
+    }
+
+    while ((done < budget) && ((num = socket_timer_pop(expired, sks)) > 0)) {
+        for (i = 0; i < num; i++) {
+            socket_del_timer(sks[i]);
+        }
 
-    while ((sk = socket_queue_first(sq)) != NULL) {
-        if (sk->timer_tsc + (timeout) <= now_tsc) {
-            socket_del_timer(sk);
-            handler(ws, sk);
-        } else {
-            break;
+        for (i = 0; i < num; i++) {
+            handler(ws, sks[i]);
         }
+        done += num;
     }
 }
 
+struct socket *socket_timer_first(struct socket_timer *timer);
 void socket_timer_init(void);
 void socket_timeout_timer_expire(struct work_space *ws);
 
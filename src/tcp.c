@@ -29,6 +29,8 @@
 #include "socket_timer.h"
 #include "loop.h"
 #include "http_parse.h"
+#include "payload.h"
+#include "tcp_reorder.h"
 
 #define tcp_seq_lt(seq0, seq1)    ((int)((seq0) - (seq1)) < 0)
 #define tcp_seq_le(seq0, seq1)    ((int)((seq0) - (seq1)) <= 0)
@@ -86,6 +88,205 @@ static inline void tcp_change_dip(struct work_space *ws, struct iphdr *iph, stru
     }
 }
 
+#ifdef HTTP_PARSE
+/* offset of 'seq' in the object, which ends at snd_max */
+static inline uint32_t tcp_object_offset(struct work_space *ws, struct socket *sk, uint32_t seq)
+{
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+    uint32_t offset = seq - (skc->snd_max - ws->payload_size);
+
+    /* not a part of the response */
+    if (unlikely(offset >= ws->payload_size)) {
+        offset = 0;
+    }
+
+    return offset;
+}
+
+static inline uint16_t tcp_object_len(struct work_space *ws, uint32_t offset)
+{
+    return RTE_MIN((uint32_t)ws->tcp_data.data.data_len, ws->payload_size - offset);
+}
+
+/*
+ * Replace the template data of 'm' with the object bytes at 'offset'.
+ * Without tcp checksum offload the bytes are copied, the checksum needs linear data.
+ * */
+static inline int tcp_object_attach(struct work_space *ws, struct rte_mbuf *m, uint32_t offset)
+{
+    struct mbuf_data *mdata = &ws->tcp_data.data;
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+    struct tcphdr *th = mbuf_tcp_hdr(m);
+    struct rte_mbuf *seg = NULL;
+    uint16_t hdr_len = mdata->total_len - mdata->data_len;
+    uint16_t len = tcp_object_len(ws, offset);
+
+    if (likely(g_dev_tx_offload_tcpudp_cksum)) {
+        seg = payload_object_slice(ws->tcp_data.mbuf_pool, ws->id, offset, len);
+        if (unlikely(seg == NULL)) {
+            return -1;
+        }
+
+        rte_pktmbuf_trim(m, mdata->data_len);
+        if (unlikely(rte_pktmbuf_chain(m, seg) < 0)) {
+            rte_pktmbuf_free(seg);
+            return -1;
+        }
+    } else {
+        /* the template data in this mbuf is overwritten */
+        mbuf_set_userdata(m, NULL);
+        memcpy(rte_pktmbuf_mtod_offset(m, uint8_t *, hdr_len), g_payload_object.data + offset, len);
+        rte_pktmbuf_trim(m, mdata->data_len - len);
+    }
+
+    if (likely(len == mdata->data_len)) {
+        return 0;
+    }
+
+    /* the last segment changes the template headers in this mbuf */
+    mbuf_set_userdata(m, NULL);
+    if (mdata->ipv6) {
+        ip6h->ip6_plen = htons(mdata->l4_len + len);
+        th->th_sum = RTE_IPV6_PHDR_CKSUM(ip6h, 0);
+    } else {
+        iph->tot_len = htons(mdata->l3_len + mdata->l4_len + len);
+        th->th_sum = RTE_IPV4_PHDR_CKSUM(iph, 0);
+    }
+
+    return 0;
+}
+
+/*
+ * RFC 7323 timestamps, the first option of our segments (see mbuf_cache_init_tcp).
+ * TSval is the tsc in units of the rtt estimator, so an echoed TSecr is an rtt sample.
+ * */
+#define TCP_TS_VAL_OFFSET   4
+#define TCP_TS_ECR_OFFSET   8
+
+static inline uint32_t tcp_ts_clock(uint64_t tsc)
+{
+    return (uint32_t)(tsc >> SOCKET_RTT_SHIFT);
+}
+
+static inline void tcp_ts_write(struct work_space *ws, struct socket *sk, struct tcphdr *th)
+{
+    uint8_t *opt = (uint8_t *)(th + 1);
+    uint32_t val = htonl(tcp_ts_clock(work_space_tsc(ws)));
+    uint32_t ecr = htonl(socket_cold_get(&ws->socket_table, sk)->ts_recent);
+
+    memcpy(opt + TCP_TS_VAL_OFFSET, &val, sizeof(uint32_t));
+    memcpy(opt + TCP_TS_ECR_OFFSET, &ecr, sizeof(uint32_t));
+}
+
+static inline bool tcp_ts_parse(struct tcphdr *th, uint32_t *val, uint32_t *ecr)
+{
+    uint32_t hdr = 0;
+    uint8_t *opt = (uint8_t *)(th + 1);
+    uint8_t *end = (uint8_t *)th + th->th_off * 4;
+
+    if ((opt + TCPOLEN_TSTAMP_APPA) > end) {
+        return false;
+    }
+
+    /* the layout of RFC 7323 appendix A, sent by dperf and most stacks */
+    memcpy(&hdr, opt, sizeof(uint32_t));
+    if (unlikely(hdr != htonl(TCPOPT_TSTAMP_HDR))) {
+        while (opt < end) {
+            if (opt[0] == TCPOPT_EOL) {
+                return false;
+            } else if (opt[0] == TCPOPT_NOP) {
+                opt++;
+                continue;
+            }
+
+            if (((opt + 1) >= end) || (opt[1] < 2) || ((opt + opt[1]) > end)) {
+                return false;
+            }
+
+            if ((opt[0] == TCPOPT_TIMESTAMP) && (opt[1] == TCPOLEN_TIMESTAMP)) {
+                break;
+            }
+            opt += opt[1];
+        }
+
+        if (opt >= end) {
+            return false;
+        }
+        /* point at the same offsets as the fast path */
+        opt -= 2;
+    }
+
+    memcpy(val, opt + TCP_TS_VAL_OFFSET, sizeof(uint32_t));
+    memcpy(ecr, opt + TCP_TS_ECR_OFFSET, sizeof(uint32_t));
+    *val = ntohl(*val);
+    *ecr = ntohl(*ecr);
+
+    return true;
+}
+
+/* PAWS only, for a segment that is queued out of order */
+static inline bool tcp_ts_paws(struct work_space *ws, struct socket *sk, struct tcphdr *th)
+{
+    uint32_t val = 0;
+    uint32_t ecr = 0;
+
+    if (tcp_ts_parse(th, &val, &ecr) == false) {
+        return true;
+    }
+
+    return !tcp_seq_lt(val, socket_cold_get(&ws->socket_table, sk)->ts_recent);
+}
+
+/* the first TSval of a connection, from a syn or a syn-ack */
+static inline void tcp_ts_recent(struct work_space *ws, struct socket *sk, struct tcphdr *th)
+{
+    uint32_t val = 0;
+    uint32_t ecr = 0;
+
+    if (tcp_ts_parse(th, &val, &ecr) == false) {
+        val = 0;
+    }
+    socket_cold_get(&ws->socket_table, sk)->ts_recent = val;
+}
+
+/*
+ * PAWS, then remember the TSval of an in-order segment and
+ * take an rtt sample from an ack of new data.
+ * */
+static inline bool tcp_ts_check(struct work_space *ws, struct socket *sk, struct tcphdr *th)
+{
+    uint32_t val = 0;
+    uint32_t ecr = 0;
+    uint32_t rtt = 0;
+    uint32_t ack = ntohl(th->th_ack);
+    struct socket_cold *skc = NULL;
+
+    if (tcp_ts_parse(th, &val, &ecr) == false) {
+        return true;
+    }
+
+    skc = socket_cold_get(&ws->socket_table, sk);
+    if (unlikely(tcp_seq_lt(val, skc->ts_recent))) {
+        return false;
+    }
+
+    if (ntohl(th->th_seq) == sk->rcv_nxt) {
+        skc->ts_recent = val;
+    }
+
+    if ((ecr != 0) && tcp_seq_gt(ack, sk->snd_una) && tcp_seq_le(ack, sk->snd_nxt)) {
+        rtt = tcp_ts_clock(work_space_tsc(ws)) - ecr;
+        net_stats_rtt_tsc((uint64_t)rtt << SOCKET_RTT_SHIFT);
+        if (g_config.adaptive_rto) {
+            socket_rtt_add(ws, sk, rtt);
+        }
+    }
+
+    return true;
+}
+#endif
+
 static inline struct rte_mbuf *tcp_new_packet(struct work_space *ws, struct socket *sk, uint8_t tcp_flags)
 {
     uint16_t csum_ip = 0;
@@ -107,6 +308,11 @@ static inline struct rte_mbuf *tcp_new_packet(struct work_space *ws, struct sock
         csum_tcp = sk->csum_tcp_data;
         csum_ip = sk->csum_ip_data;
         snd_seq = p->data.data_len;
+#ifdef HTTP_PARSE
+        if (unlikely(ws->payload_object)) {
+            snd_seq = tcp_object_len(ws, tcp_object_offset(ws, sk, sk->snd_una));
+        }
+#endif
         if (tcp_flags & TH_URG) {
             tcp_flags &= ~(TH_URG|TH_PUSH);
         }
@@ -168,6 +374,17 @@ static inline struct rte_mbuf *tcp_new_packet(struct work_space *ws, struct sock
     th->th_ack = htonl(sk->rcv_nxt);
     th->th_sum = csum_tcp;
 
+#ifdef HTTP_PARSE
+    if (ws->timestamps) {
+        tcp_ts_write(ws, sk, th);
+    }
+
+    /* a delayed ack is piggybacked */
+    if (ws->ack_delay.head != ws->ack_delay.tail) {
+        socket_cold_get(&ws->socket_table, sk)->ack_delay = 0;
+    }
+#endif
+
 #ifdef DPERF_DEBUG
     if ((tcp_flags & TH_SYN) && ((sk->lport == htons(80)) || (sk->fport == htons(80)))) {
         MBUF_LOG(m, "syn-tx");
@@ -183,6 +400,16 @@ static inline struct rte_mbuf *tcp_new_packet(struct work_space *ws, struct sock
         tcp_change_dip(ws, iph, th);
     }
 
+#ifdef HTTP_PARSE
+    /* a failure looks like a lost segment */
+    if (unlikely(ws->payload_object) && (p == &ws->tcp_data)) {
+        if (unlikely(tcp_object_attach(ws, m, tcp_object_offset(ws, sk, sk->snd_una)) < 0)) {
+            rte_pktmbuf_free(m);
+            return NULL;
+        }
+    }
+#endif
+
     return m;
 }
 
@@ -220,6 +447,7 @@ static struct rte_mbuf *tcp_reply(struct work_space *ws, struct socket *sk, uint
 {
     struct rte_mbuf *m = NULL;
     uint64_t now_tsc = 0;
+    int num = ws->http_pipeline;
 
     now_tsc = work_space_tsc(ws);
     sk->flags = tcp_flags;
@@ -227,12 +455,16 @@ static struct rte_mbuf *tcp_reply(struct work_space *ws, struct socket *sk, uint
 
     if (tcp_flags & TH_PUSH) {
         if (g_config.server == 0) {
-            net_stats_tcp_req();
-            if (g_config.http_method == HTTP_METH_GET) {
-                net_stats_http_get();
-            } else {
-                net_stats_http_post();
-            }
+            /* a segment of pipelined requests */
+            do {
+                net_stats_tcp_req();
+                if (g_config.http_method == HTTP_METH_GET) {
+                    net_stats_http_get();
+                } else {
+                    net_stats_http_post();
+                }
+                num--;
+            } while (num > 0);
         } else {
             if (ws->send_window == 0) {
                 net_stats_tcp_rsp();
@@ -263,6 +495,70 @@ static struct rte_mbuf *tcp_reply(struct work_space *ws, struct socket *sk, uint
     return m;
 }
 
+#ifdef HTTP_PARSE
+/* an entry is stale once its socket is queued again */
+static inline void tcp_ack_delay_pop(struct work_space *ws)
+{
+    struct tcp_ack_delay_entry *e = &ws->ack_delay.fifo[ws->ack_delay.head & TCP_ACK_DELAY_MASK];
+    struct socket *sk = e->sk;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+
+    ws->ack_delay.head++;
+    if (skc->ack_deadline != e->deadline) {
+        return;
+    }
+
+    skc->ack_deadline = 0;
+    if (skc->ack_delay) {
+        skc->ack_delay = 0;
+        if (sk->state == SK_ESTABLISHED) {
+            tcp_reply(ws, sk, TH_ACK);
+        }
+    }
+}
+
+/*
+ * Delayed ack: a socket with data to ack waits in a fifo of the worker. The ack is sent
+ * when the delay expires, after 'segs' segments, or with the next packet of the socket.
+ * The delay is the same for all sockets, so the fifo is in the order of the deadlines.
+ * A socket acked by its own packet may be queued again before its old entry pops, so
+ * only the entry of skc->ack_deadline is live. When the fifo is full, the oldest entry
+ * is popped, and its socket is acked early.
+ * */
+static inline void tcp_ack_delay(struct work_space *ws, struct socket *sk)
+{
+    uint64_t deadline = 0;
+    struct tcp_ack_delay_entry *e = NULL;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+
+    if (skc->ack_delay == 0) {
+        deadline = work_space_tsc(ws) + ws->ack_delay.delay;
+        /* queued again in the same loop, its entry is still in the fifo */
+        if (skc->ack_deadline != deadline) {
+            if (unlikely((ws->ack_delay.tail - ws->ack_delay.head) >= TCP_ACK_DELAY_MAX)) {
+                tcp_ack_delay_pop(ws);
+            }
+
+            e = &ws->ack_delay.fifo[ws->ack_delay.tail & TCP_ACK_DELAY_MASK];
+            e->deadline = deadline;
+            e->sk = sk;
+            ws->ack_delay.tail++;
+            skc->ack_deadline = deadline;
+        }
+        skc->ack_delay = 1;
+        skc->ack_segs = 0;
+    }
+
+    if (skc->ack_segs < UINT8_MAX) {
+        skc->ack_segs++;
+    }
+
+    if (ws->ack_delay.segs && (skc->ack_segs >= ws->ack_delay.segs)) {
+        tcp_reply(ws, sk, TH_ACK);
+    }
+}
+#endif
+
 extern void tcp_socket_send_rst(struct work_space *ws, struct socket *sk);
 void tcp_socket_send_rst(struct work_space *ws, struct socket *sk)
 {
@@ -377,10 +673,71 @@ static void tcp_reply_rst(struct work_space *ws, struct rte_mbuf *m)
     work_space_tx_send(ws, m);
 }
 
+#ifdef HTTP_PARSE
+/*
+ * snd_window is the burst per ack, and with congestion control also the window
+ * in flight, see tcp_reply_more().
+ * */
+static inline void tcp_window_set(struct socket_cold *skc)
+{
+    if (skc->cwnd > g_config.send_window) {
+        skc->cwnd = g_config.send_window;
+    } else if (skc->cwnd == 0) {
+        skc->cwnd = 1;
+    }
+    skc->snd_window = skc->cwnd;
+}
+
+static inline void tcp_window_init(struct work_space *ws, struct socket_cold *skc)
+{
+    if (ws->tcp_cc) {
+        ws->tcp_cc->init(skc);
+        tcp_window_set(skc);
+    }
+}
+
+static inline void tcp_window_ack(struct work_space *ws, struct socket_cold *skc, uint32_t acked)
+{
+    uint32_t mss = ws->tcp_data.data.data_len;
+
+    if (ws->tcp_cc) {
+        if (acked) {
+            ws->tcp_cc->ack(skc, (acked + mss - 1) / mss, work_space_tsc(ws));
+            tcp_window_set(skc);
+        }
+    } else if (skc->snd_window < SEND_WINDOW_MAX) {
+        skc->snd_window++;
+    }
+}
+
+static inline void tcp_window_loss(struct work_space *ws, struct socket_cold *skc, uint8_t snd_window)
+{
+    if (ws->tcp_cc) {
+        ws->tcp_cc->loss(skc);
+        tcp_window_set(skc);
+    } else {
+        skc->snd_window = snd_window;
+    }
+}
+
+static inline void tcp_window_timeout(struct work_space *ws, struct socket_cold *skc)
+{
+    if (ws->tcp_cc) {
+        ws->tcp_cc->timeout(skc);
+        tcp_window_set(skc);
+    } else {
+        skc->snd_window = 1;
+    }
+}
+#endif
+
 static inline void tcp_do_retransmit(struct work_space *ws, struct socket *sk)
 {
     uint32_t snd_nxt = 0;
     uint8_t flags = 0;
+#ifdef HTTP_PARSE
+    struct socket_cold *skc = NULL;
+#endif
 
     if (sk->snd_nxt == sk->snd_una) {
         sk->retrans = 0;
@@ -404,7 +761,10 @@ static inline void tcp_do_retransmit(struct work_space *ws, struct socket *sk)
             tcp_reply(ws, sk, TH_PUSH | TH_ACK);
             sk->snd_nxt = snd_nxt;
 #ifdef HTTP_PARSE
-            sk->snd_window = 1;
+            skc = socket_cold_get(&ws->socket_table, sk);
+            tcp_window_timeout(ws, skc);
+            /* timeout ends the fast recovery */
+            skc->snd_recover = sk->snd_una;
 #endif
             net_stats_push_rt();
             socket_start_retransmit_timer(sk, work_space_tsc(ws));
@@ -437,6 +797,11 @@ static inline void tcp_server_process_syn(struct work_space *ws, struct socket *
 
     if (sk->state == SK_CLOSED) {
         socket_server_open(&ws->socket_table, sk, th);
+#ifdef HTTP_PARSE
+        if (ws->timestamps) {
+            tcp_ts_recent(ws, sk, th);
+        }
+#endif
         tcp_reply(ws, sk, TH_SYN | TH_ACK);
     } else if (sk->state == SK_SYN_RECEIVED) {
         /* syn-ack lost, resend it */
@@ -473,6 +838,14 @@ static inline void tcp_client_process_syn_ack(struct work_space *ws, struct sock
         }
 
         net_stats_rtt(ws, sk);
+        if (g_config.adaptive_rto && (sk->retrans == 0)) {
+            socket_rtt_sample(ws, sk, work_space_tsc(ws));
+        }
+#ifdef HTTP_PARSE
+        if (ws->timestamps) {
+            tcp_ts_recent(ws, sk, th);
+        }
+#endif
         sk->rcv_nxt = seq + 1;
         sk->snd_una = ack;
         sk->state = SK_ESTABLISHED;
@@ -495,13 +868,160 @@ out:
     mbuf_free2(m);
 }
 
-static inline bool tcp_check_sequence(struct work_space *ws, struct socket *sk, struct tcphdr *th, uint16_t data_len)
+#ifdef HTTP_PARSE
+#define TCP_SACK_BLOCK_MAX  4
+
+struct tcp_sack_block {
+    uint32_t left;
+    uint32_t right;
+};
+
+/* valid sack blocks of an ack, sorted by the left edge */
+static inline int tcp_sack_parse(struct socket *sk, struct tcphdr *th, struct tcp_sack_block *blocks)
+{
+    int i = 0;
+    int j = 0;
+    int num = 0;
+    uint8_t len = 0;
+    uint8_t *opt = (uint8_t *)(th + 1);
+    uint8_t *end = (uint8_t *)th + th->th_off * 4;
+    struct tcp_sack_block block;
+
+    while (opt < end) {
+        if (opt[0] == TCPOPT_EOL) {
+            break;
+        } else if (opt[0] == TCPOPT_NOP) {
+            opt++;
+            continue;
+        }
+
+        if (((opt + 1) >= end) || (opt[1] < 2) || ((opt + opt[1]) > end)) {
+            break;
+        }
+
+        len = opt[1];
+        if (opt[0] == TCPOPT_SACK) {
+            for (i = 2; ((i + 8) <= len) && (num < TCP_SACK_BLOCK_MAX); i += 8) {
+                memcpy(&block, opt + i, sizeof(block));
+                block.left = ntohl(block.left);
+                block.right = ntohl(block.right);
+                if (tcp_seq_le(block.left, sk->snd_una) || tcp_seq_le(block.right, block.left) ||
+                    tcp_seq_gt(block.right, sk->snd_nxt)) {
+                    continue;
+                }
+
+                for (j = num; (j > 0) && tcp_seq_lt(block.left, blocks[j - 1].left); j--) {
+                    blocks[j] = blocks[j - 1];
+                }
+                blocks[j] = block;
+                num++;
+            }
+            break;
+        }
+        opt += len;
+    }
+
+    return num;
+}
+
+static inline void tcp_send_segment(struct work_space *ws, struct socket *sk, uint32_t seq)
+{
+    uint32_t snd_una = sk->snd_una;
+    uint32_t snd_nxt = sk->snd_nxt;
+
+    /* we always send from <snd_una> */
+    sk->snd_una = seq;
+    sk->snd_nxt = seq;
+    tcp_reply(ws, sk, TH_PUSH | TH_ACK);
+    sk->snd_una = snd_una;
+    sk->snd_nxt = snd_nxt;
+    net_stats_push_rt();
+}
+
+/*
+ * Resend the holes below the highest sacked sequence that are not resent yet, at most
+ * snd_window segments per ack. Without sack blocks, the hole is at snd_una.
+ * */
+static inline void tcp_sack_retransmit(struct work_space *ws, struct socket *sk, struct socket_cold *skc,
+    struct tcp_sack_block *blocks, int num)
+{
+    int i = 0;
+    int sent = 0;
+    uint32_t mss = ws->tcp_data.data.data_len;
+    uint32_t seq = sk->snd_una;
+
+    if (tcp_seq_gt(skc->snd_rexmit, seq)) {
+        seq = skc->snd_rexmit;
+    }
+
+    if (num == 0) {
+        if (seq == sk->snd_una) {
+            tcp_send_segment(ws, sk, seq);
+            skc->snd_rexmit = seq + mss;
+        }
+        return;
+    }
+
+    for (i = 0; (i < num) && (sent < skc->snd_window); i++) {
+        while (tcp_seq_lt(seq, blocks[i].left) && (sent < skc->snd_window)) {
+            tcp_send_segment(ws, sk, seq);
+            seq += mss;
+            sent++;
+        }
+
+        if ((sent < skc->snd_window) && tcp_seq_lt(seq, blocks[i].right)) {
+            seq = blocks[i].right;
+        }
+    }
+
+    skc->snd_rexmit = seq;
+}
+
+/* fast retransmit on the third duplicate ack, then fast recovery until snd_recover is acked */
+static inline void tcp_sack_dup_ack(struct work_space *ws, struct socket *sk, struct socket_cold *skc,
+    struct tcphdr *th)
+{
+    int num = 0;
+    struct tcp_sack_block blocks[TCP_SACK_BLOCK_MAX];
+
+    if (tcp_seq_lt(sk->snd_una, skc->snd_recover)) {
+        /* the duplicate ack count is not needed any more */
+        sk->retrans = 0;
+        num = tcp_sack_parse(sk, th, blocks);
+        tcp_sack_retransmit(ws, sk, skc, blocks, num);
+        return;
+    }
+
+    if (sk->retrans < 3) {
+        return;
+    }
+
+    sk->retrans = 0;
+    skc->snd_recover = sk->snd_nxt;
+    skc->snd_rexmit = sk->snd_una;
+    tcp_window_loss(ws, skc, RTE_MAX(skc->snd_window / 2, 1));
+    num = tcp_sack_parse(sk, th, blocks);
+    tcp_sack_retransmit(ws, sk, skc, blocks, num);
+}
+#endif
+
+/* 'ts' is false for a segment out of the reorder queue, it passed PAWS when it was queued */
+static inline bool tcp_check_sequence(struct work_space *ws, struct socket *sk, struct tcphdr *th, uint16_t data_len,
+    __rte_unused bool ts)
 {
     uint32_t ack = ntohl(th->th_ack);
     uint32_t seq = ntohl(th->th_seq);
     uint32_t snd_last = sk->snd_una;
+    uint8_t retrans = sk->retrans;
 #ifdef HTTP_PARSE
     uint32_t snd_nxt = 0;
+    struct socket_cold *skc = NULL;
+#endif
+
+#ifdef HTTP_PARSE
+    if (ts && (tcp_ts_check(ws, sk, th) == false)) {
+        return false;
+    }
 #endif
 
     if (th->th_flags & TH_FIN) {
@@ -517,13 +1037,16 @@ static inline bool tcp_check_sequence(struct work_space *ws, struct socket *sk,
 
             if (ws->send_window == 0) {
                 if (snd_last != ack) {
+                    /* Karn: no sample from a retransmitted segment, timestamps sample every ack */
+                    if (g_config.adaptive_rto && (retrans == 0) && (ws->timestamps == 0)) {
+                        socket_rtt_sample(ws, sk, work_space_tsc(ws));
+                    }
                     socket_stop_retransmit_timer(sk);
                 }
             } else {
 #ifdef HTTP_PARSE
-                if (sk->snd_window < SEND_WINDOW_MAX) {
-                    sk->snd_window++;
-                }
+                skc = socket_cold_get(&ws->socket_table, sk);
+                tcp_window_ack(ws, skc, ack - snd_last);
 #endif
             }
             return true;
@@ -550,17 +1073,26 @@ static inline bool tcp_check_sequence(struct work_space *ws, struct socket *sk,
     if (tcp_seq_le(ack, sk->snd_nxt)) {
         if (ws->send_window) {
 #ifdef HTTP_PARSE
+            skc = socket_cold_get(&ws->socket_table, sk);
             /* new data is acked */
             if ((tcp_seq_gt(ack, sk->snd_una))) {
                 sk->snd_una = ack;
-                if (sk->snd_window < SEND_WINDOW_MAX) {
-                    sk->snd_window++;
-                }
                 sk->retrans = 0;
+                if (g_config.sack && tcp_seq_lt(ack, skc->snd_recover)) {
+                    /* partial ack: the next hole is lost too */
+                    tcp_sack_dup_ack(ws, sk, skc, th);
+                } else {
+                    tcp_window_ack(ws, skc, ack - snd_last);
+                }
                 return true;
             } else if (ack == sk->snd_una) {
                 sk->retrans++;
                 net_stats_ack_dup();
+                if (g_config.sack) {
+                    tcp_sack_dup_ack(ws, sk, skc, th);
+                    return false;
+                }
+
                 /* 3 ACK means packets loss. */
                 if (sk->retrans < 3) {
                     return false;
@@ -571,7 +1103,7 @@ static inline bool tcp_check_sequence(struct work_space *ws, struct socket *sk,
                 tcp_reply(ws, sk, TH_PUSH | TH_ACK);
                 sk->snd_nxt = snd_nxt;
                 sk->retrans = 0;
-                sk->snd_window = 1;
+                tcp_window_loss(ws, skc, 1);
                 return false;
             } else {
                 /* stale ack */
@@ -666,18 +1198,143 @@ static inline uint8_t tcp_process_fin(struct socket *sk, uint8_t rx_flags, uint8
 }
 
 #ifdef HTTP_PARSE
+static inline void tcp_offload_tso(struct rte_mbuf *m, uint16_t mss)
+{
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+    struct tcphdr *th = mbuf_tcp_hdr(m);
+
+    m->l2_len = sizeof(struct eth_hdr);
+    m->l4_len = th->th_off * 4;
+    m->tso_segsz = mss;
+    if (iph->version == 4) {
+        m->l3_len = sizeof(struct iphdr);
+        m->ol_flags = RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_IPV4 | RTE_MBUF_F_TX_IP_CKSUM;
+        iph->ttl = DEFAULT_TTL;
+        iph->tot_len = htons(rte_pktmbuf_pkt_len(m) - m->l2_len);
+        iph->check = 0;
+        th->th_sum = RTE_IPV4_PHDR_CKSUM(iph, m->ol_flags);
+    } else {
+        m->l3_len = sizeof(struct ip6_hdr);
+        m->ol_flags = RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_IPV6;
+        ip6h->ip6_hops = DEFAULT_TTL;
+        ip6h->ip6_plen = htons(rte_pktmbuf_pkt_len(m) - m->l2_len - m->l3_len);
+        th->th_sum = RTE_IPV6_PHDR_CKSUM(ip6h, m->ol_flags);
+    }
+}
+
+/* the rest of a tso packet of an object is one slice, from snd_nxt */
+static inline int tcp_object_tso(struct work_space *ws, struct socket *sk, struct rte_mbuf *m, int num)
+{
+    uint16_t mss = ws->tcp_data.data.data_len;
+    uint32_t offset = tcp_object_offset(ws, sk, sk->snd_nxt);
+    uint32_t len = RTE_MIN((uint32_t)(num - 1) * mss, ws->payload_size - offset);
+    struct rte_mbuf *seg = NULL;
+
+    if (len == 0) {
+        return 1;
+    }
+
+    seg = payload_object_slice(ws->tcp_data.mbuf_pool, ws->id, offset, len);
+    if (unlikely(seg == NULL)) {
+        return 1;
+    }
+
+    if (unlikely(rte_pktmbuf_chain(m, seg) < 0)) {
+        rte_pktmbuf_free(seg);
+        return 1;
+    }
+
+    return 1 + (len + mss - 1) / mss;
+}
+
+/*
+ * Send 'num' segments from snd_nxt in one packet, the NIC cuts it into mss segments.
+ * The other segments are the data of the same template without headers.
+ * */
+static inline int tcp_reply_tso(struct work_space *ws, struct socket *sk, uint8_t tcp_flags, int num)
+{
+    int i = 0;
+    struct rte_mbuf *m = NULL;
+    struct rte_mbuf *seg = NULL;
+    struct mbuf_data *mdata = &ws->tcp_data.data;
+    uint16_t mss = mdata->data_len;
+    uint32_t snd_nxt = 0;
+
+    sk->flags = tcp_flags;
+    m = tcp_new_packet(ws, sk, tcp_flags);
+    if (m == NULL) {
+        return 1;
+    }
+
+    if (ws->payload_object) {
+        i = tcp_object_tso(ws, sk, m, num);
+        snd_nxt = sk->snd_nxt + rte_pktmbuf_pkt_len(m) - mdata->total_len;
+    } else {
+        for (i = 1; i < num; i++) {
+            seg = mbuf_cache_alloc_payload(&ws->tcp_data);
+            if (unlikely(seg == NULL)) {
+                break;
+            }
+
+            if (unlikely(rte_pktmbuf_chain(m, seg) < 0)) {
+                rte_pktmbuf_free(seg);
+                break;
+            }
+        }
+        snd_nxt = sk->snd_nxt + (i - 1) * mss;
+    }
+
+    if (i == 1) {
+        work_space_tx_send_tcp(ws, m);
+        return 1;
+    }
+
+    /* the headers in this mbuf are changed for tso */
+    mbuf_set_userdata(m, NULL);
+    sk->snd_nxt = snd_nxt;
+    ws->ip_id += i - 1;
+    tcp_offload_tso(m, mss);
+    net_stats_tcp_tx();
+    net_stats_tso_tx(i - 1, mdata->total_len);
+    work_space_tx_send(ws, m);
+
+    return i;
+}
+
+/* segments from snd_nxt to 'end' */
+static inline int tcp_segment_num(struct work_space *ws, struct socket *sk, uint32_t end)
+{
+    uint32_t mss = ws->tcp_data.data.data_len;
+
+    return (end - sk->snd_nxt + mss - 1) / mss;
+}
+
 static inline void tcp_reply_more(struct work_space *ws, struct socket *sk)
 {
     int i = 0;
+    int num = 0;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
     uint32_t snd_una = sk->snd_una;
-    uint32_t snd_max = sk->snd_max;
+    uint32_t snd_max = skc->snd_max;
     uint32_t snd_wnd = snd_una + ws->send_window;
 
+    if (ws->tcp_cc) {
+        snd_wnd = snd_una + skc->cwnd * ws->tcp_data.data.data_len;
+    }
+
     /* wait a burst finish */
-    while (tcp_seq_lt(sk->snd_nxt, snd_wnd) && tcp_seq_lt(sk->snd_nxt, snd_max) && (i < sk->snd_window)) {
+    while (tcp_seq_lt(sk->snd_nxt, snd_wnd) && tcp_seq_lt(sk->snd_nxt, snd_max) && (i < skc->snd_window)) {
         sk->snd_una = sk->snd_nxt;
-        tcp_reply(ws, sk, TH_PUSH | TH_ACK | TH_URG);
-        i++;
+        if (ws->tso) {
+            num = RTE_MIN(tcp_segment_num(ws, sk, snd_wnd), tcp_segment_num(ws, sk, snd_max));
+            num = RTE_MIN(num, skc->snd_window - i);
+            num = RTE_MIN(num, ws->tso_seg_max);
+            i += tcp_reply_tso(ws, sk, TH_PUSH | TH_ACK | TH_URG, num);
+        } else {
+            tcp_reply(ws, sk, TH_PUSH | TH_ACK | TH_URG);
+            i++;
+        }
     }
 
     sk->snd_una = snd_una;
@@ -690,18 +1347,102 @@ static inline void tcp_reply_more(struct work_space *ws, struct socket *sk)
         }
     }
 }
+
+/* gro/lro: the data continues in the next segments of the mbuf */
+static inline int http_parse_run_mbuf(struct socket *sk, struct socket_cold *skc, struct rte_mbuf *m,
+    uint8_t *data, uint16_t data_len)
+{
+    int ret = 0;
+    uint16_t len = rte_pktmbuf_data_len(m) - (data - rte_pktmbuf_mtod(m, uint8_t *));
+
+    if (likely(m->nb_segs == 1) || (len >= data_len)) {
+        return http_parse_run(sk, skc, data, data_len);
+    }
+
+    ret = http_parse_run(sk, skc, data, len);
+    data_len -= len;
+    /* a message of a pipeline may end at a segment boundary */
+    for (m = m->next; (m != NULL) && (data_len > 0) && (ret != HTTP_PARSE_ERR); m = m->next) {
+        len = RTE_MIN(rte_pktmbuf_data_len(m), data_len);
+        ret = http_parse_run(sk, skc, rte_pktmbuf_mtod(m, uint8_t *), len);
+        data_len -= len;
+    }
+
+    return ret;
+}
+
+/*
+ * pipeline: all complete requests of the segment are answered, their responses
+ * are appended to the ones still in the send window. Return the number of requests.
+ * */
+static inline int tcp_server_pipeline(struct work_space *ws, struct socket *sk, struct rte_mbuf *m,
+    uint8_t *data, uint16_t data_len)
+{
+    int i = 0;
+    int num = 0;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+    uint32_t rsp_len = RTE_MAX(ws->payload_size, (uint32_t)ws->tcp_data.data.data_len);
+
+    if (http_parse_run_mbuf(sk, skc, m, data, data_len) == HTTP_PARSE_ERR) {
+        socket_init_http(skc);
+        net_stats_http_error();
+        return -1;
+    }
+
+    num = skc->http_done;
+    skc->http_done = 0;
+    if (num == 0) {
+        return 0;
+    }
+
+    if ((sk->keepalive_request_num == 0) || (sk->snd_una == skc->snd_max)) {
+        skc->snd_max = sk->snd_nxt + num * rsp_len;
+        skc->snd_recover = sk->snd_nxt;
+        skc->snd_rexmit = sk->snd_nxt;
+    } else {
+        skc->snd_max += num * rsp_len;
+    }
+
+    for (i = 0; i < num; i++) {
+        net_stats_tcp_rsp();
+        net_stats_http_2xx();
+    }
+
+    return num;
+}
+
+/* the first response starts the window */
+static inline void tcp_server_reply_window(struct work_space *ws, struct socket *sk)
+{
+    if (sk->keepalive_request_num) {
+        tcp_reply_more(ws, sk);
+    } else if (ws->tcp_cc) {
+        /* initial window */
+        tcp_window_init(ws, socket_cold_get(&ws->socket_table, sk));
+        tcp_reply_more(ws, sk);
+        sk->keepalive_request_num = 1;
+    } else {
+        /* slow start */
+        tcp_reply(ws, sk, TH_PUSH | TH_ACK);
+        sk->keepalive_request_num = 1;
+    }
+    socket_start_retransmit_timer(sk, work_space_tsc(ws));
+}
 #endif
 
 static inline void tcp_server_process_data(struct work_space *ws, struct socket *sk, struct rte_mbuf *m,
     struct iphdr *iph, struct tcphdr *th)
 {
+#ifdef HTTP_PARSE
+    int num = 0;
+#endif
     uint8_t *data = NULL;
     uint8_t tx_flags = 0;
     uint8_t rx_flags = th->th_flags;
     uint16_t data_len = 0;
 
     data = tcp_data_get(iph, th,  &data_len);
-    if (tcp_check_sequence(ws, sk, th, data_len) == false) {
+    if (tcp_check_sequence(ws, sk, th, data_len, ws->timestamps) == false) {
         SOCKET_LOG_ENABLE(sk);
         MBUF_LOG(m, "drop-bad-seq");
         SOCKET_LOG(sk, "drop-bad-seq");
@@ -715,20 +1456,28 @@ static inline void tcp_server_process_data(struct work_space *ws, struct socket
 
     if (sk->state == SK_ESTABLISHED) {
 #ifdef HTTP_PARSE
-        if (data_len) {
+        if (data_len && ws->http_pipeline) {
+            num = tcp_server_pipeline(ws, sk, m, data, data_len);
+            if (num < 0) {
+                sk->keepalive = 0;
+                tx_flags |= TH_ACK | TH_FIN;
+            } else if ((num > 0) && ((rx_flags & TH_FIN) == 0)) {
+                tcp_server_reply_window(ws, sk);
+                goto out;
+            } else if ((rx_flags & TH_FIN) == 0) {
+                /* a part of a request, acked with the response */
+                tcp_ack_delay(ws, sk);
+                goto out;
+            } else {
+                tx_flags |= TH_ACK;
+            }
+        } else if (data_len) {
             http_parse_request(data, data_len);
             if ((ws->send_window) && ((rx_flags & TH_FIN) == 0)) {
-                socket_init_http_server(sk, ws->payload_size);
+                socket_init_http_server(sk, socket_cold_get(&ws->socket_table, sk), ws->payload_size);
                 net_stats_tcp_rsp();
                 net_stats_http_2xx();
-                if (sk->keepalive_request_num) {
-                    tcp_reply_more(ws, sk);
-                } else {
-                    /* slow start */
-                    tcp_reply(ws, sk, TH_PUSH | TH_ACK);
-                    sk->keepalive_request_num = 1;
-                }
-                socket_start_retransmit_timer(sk, work_space_tsc(ws));
+                tcp_server_reply_window(ws, sk);
                 goto out;
             } else {
                 tx_flags |= TH_PUSH | TH_ACK;
@@ -766,58 +1515,52 @@ out:
 }
 
 #ifdef HTTP_PARSE
-static inline void tcp_ack_delay_add(struct work_space *ws, struct socket *sk)
-{
-    if (sk->http_ack) {
-        return;
-    }
-
-    if (ws->ack_delay.next >= TCP_ACK_DELAY_MAX) {
-        tcp_ack_delay_flush(ws);
-    }
-
-    ws->ack_delay.sockets[ws->ack_delay.next] = sk;
-    ws->ack_delay.next++;
-    sk->http_ack = 1;
-}
-
-static inline uint8_t http_client_process_data(struct work_space *ws, struct socket *sk,
+static inline uint8_t http_client_process_data(struct work_space *ws, struct socket *sk, struct rte_mbuf *m,
     uint8_t rx_flags, uint8_t *data, uint16_t data_len)
 {
     int ret = 0;
     int8_t tx_flags = 0;
     uint8_t http_frags = 0;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+
+    ret = http_parse_run_mbuf(sk, skc, m, data, data_len);
+    /* more responses of the pipeline */
+    if ((ret == HTTP_PARSE_END) && (skc->http_done < ws->http_pipeline)) {
+        ret = HTTP_PARSE_OK;
+    }
 
-    ret = http_parse_run(sk, data, data_len);
     if (ret == HTTP_PARSE_OK) {
-        if (sk->http_frags < 4) {
-            sk->http_frags++;
+        if (skc->http_frags < 4) {
+            skc->http_frags++;
         }
         if ((rx_flags & TH_FIN) == 0) {
-            tcp_ack_delay_add(ws, sk);
+            tcp_ack_delay(ws, sk);
             return 0;
         }
     } else if (ret == HTTP_PARSE_END) {
-        http_frags = sk->http_frags;
-        socket_init_http(sk);
+        http_frags = skc->http_frags;
+        socket_init_http(skc);
         if (sk->keepalive && ((rx_flags & TH_FIN) == 0)) {
             /* we should ack now:
              * 1. 3 http fragments are not ACKed
              * 2. we want ack each data quickly(disable_ack == 0), except we will send out our next request shortly.
              * */
-            if ((http_frags >= 2) || ((g_config.keepalive_request_interval >= g_config.retransmit_timeout) && (ws->disable_ack == 0))) {
-                tcp_ack_delay_add(ws, sk);
+            if (ws->ack_delay.enable || (http_frags >= 2)
+                || ((g_config.keepalive_request_interval >= g_config.retransmit_timeout) && (ws->disable_ack == 0))) {
+                tcp_ack_delay(ws, sk);
+            } else {
+                /* left to the next request */
+                skc->ack_delay = 0;
             }
             socket_start_keepalive_timer(sk, work_space_tsc(ws));
             return 0;
         } else {
             tx_flags |= TH_FIN;
-            sk->http_ack = 0;
         }
     } else {
-        socket_init_http(sk);
+        socket_init_http(skc);
         sk->keepalive = 0;
-        sk->http_length = 0;
+        skc->http_length = 0;
         tx_flags |= TH_FIN;
         net_stats_http_error();
     }
@@ -842,8 +1585,31 @@ static inline void tcp_send_keepalive_request(struct work_space *ws, struct sock
     }
 }
 
+#ifdef HTTP_PARSE
+/* a segment after a hole waits for it, the duplicate ack asks for the hole */
+static inline void tcp_client_reorder(struct work_space *ws, struct socket *sk, struct rte_mbuf *m)
+{
+    struct tcphdr *th = mbuf_tcp_hdr(m);
+
+    if (ws->timestamps && (tcp_ts_paws(ws, sk, th) == false)) {
+        MBUF_LOG(m, "drop-bad-seq");
+        net_stats_tcp_drop();
+        mbuf_free2(m);
+        return;
+    }
+
+    if (tcp_reorder_insert(ws, socket_cold_get(&ws->socket_table, sk), m, ntohl(th->th_seq)) < 0) {
+        MBUF_LOG(m, "drop-reorder");
+        net_stats_tcp_drop();
+        mbuf_free2(m);
+    }
+
+    tcp_reply(ws, sk, TH_ACK);
+}
+#endif
+
 static inline void tcp_client_process_data(struct work_space *ws, struct socket *sk, struct rte_mbuf *m,
-    struct iphdr *iph, struct tcphdr *th)
+    struct iphdr *iph, struct tcphdr *th, bool reordered)
 {
     uint8_t *data = NULL;
     uint8_t tx_flags = 0;
@@ -851,7 +1617,13 @@ static inline void tcp_client_process_data(struct work_space *ws, struct socket
     uint16_t data_len = 0;
 
     data = tcp_data_get(iph, th, &data_len);
-    if (tcp_check_sequence(ws, sk, th, data_len) == false) {
+#ifdef HTTP_PARSE
+    if (unlikely(ws->reorder != NULL) && data_len && (sk->state == SK_ESTABLISHED) &&
+        tcp_seq_gt(ntohl(th->th_seq), sk->rcv_nxt) && (ntohl(th->th_ack) == sk->snd_nxt)) {
+        return tcp_client_reorder(ws, sk, m);
+    }
+#endif
+    if (tcp_check_sequence(ws, sk, th, data_len, ws->timestamps && !reordered) == false) {
         SOCKET_LOG_ENABLE(sk);
         MBUF_LOG(m, "drop-bad-seq");
         SOCKET_LOG(sk, "drop-bad-seq");
@@ -863,7 +1635,7 @@ static inline void tcp_client_process_data(struct work_space *ws, struct socket
         if (data_len) {
 #ifdef HTTP_PARSE
             if (ws->http) {
-                tx_flags = http_client_process_data(ws, sk, rx_flags, data, data_len);
+                tx_flags = http_client_process_data(ws, sk, m, rx_flags, data, data_len);
             } else
 #endif
             {
@@ -894,8 +1666,13 @@ static inline void tcp_client_process_data(struct work_space *ws, struct socket
 
     if (tx_flags != 0) {
         /* delay ack */
-        if ((rx_flags & TH_FIN) || (tx_flags != TH_ACK) || (sk->keepalive == 0)
-            || (sk->keepalive && (g_config.keepalive_request_interval >= g_config.retransmit_timeout) && (ws->disable_ack == 0))) {
+        if ((rx_flags & TH_FIN) || (tx_flags != TH_ACK) || (sk->keepalive == 0)) {
+            tcp_reply(ws, sk, tx_flags);
+#ifdef HTTP_PARSE
+        } else if (ws->ack_delay.enable) {
+            tcp_ack_delay(ws, sk);
+#endif
+        } else if ((g_config.keepalive_request_interval >= g_config.retransmit_timeout) && (ws->disable_ack == 0)) {
             tcp_reply(ws, sk, tx_flags);
         }
     }
@@ -904,6 +1681,117 @@ out:
     mbuf_free2(m);
 }
 
+/*
+ * SYN cookies of the hash socket table. The isn of a syn-ack is a 5-bit time slot
+ * of 64 seconds and a hash of the tuple, the client isn and the slot. No socket
+ * is created until the handshake ack echoes a valid cookie.
+ * */
+#define TCP_SYN_COOKIE_SLOT_SHIFT   6
+#define TCP_SYN_COOKIE_SLOT_BITS    5
+#define TCP_SYN_COOKIE_HASH_BITS    (32 - TCP_SYN_COOKIE_SLOT_BITS)
+#define TCP_SYN_COOKIE_HASH_MASK    ((1u << TCP_SYN_COOKIE_HASH_BITS) - 1)
+#define TCP_SYN_COOKIE_SLOT_MASK    ((1u << TCP_SYN_COOKIE_SLOT_BITS) - 1)
+
+static inline uint32_t tcp_syn_cookie_slot(struct work_space *ws)
+{
+    return (uint32_t)((work_space_tsc(ws) / TSC_PER_SEC) >> TCP_SYN_COOKIE_SLOT_SHIFT);
+}
+
+static inline uint32_t tcp_syn_cookie_make(const struct socket_table *st, uint32_t saddr, uint32_t daddr,
+    const struct tcphdr *th, uint32_t isn, uint32_t slot)
+{
+    uint32_t h = socket_hash_tuple(saddr, daddr, th->th_sport, th->th_dport);
+
+    h = rte_hash_crc_4byte(isn, rte_hash_crc_4byte(slot, h ^ st->syn_cookie_secret));
+
+    return ((slot & TCP_SYN_COOKIE_SLOT_MASK) << TCP_SYN_COOKIE_HASH_BITS) | (h & TCP_SYN_COOKIE_HASH_MASK);
+}
+
+/* a cookie of this slot or of the previous one */
+static inline bool tcp_syn_cookie_check(struct work_space *ws, uint32_t saddr, uint32_t daddr,
+    const struct tcphdr *th, uint32_t isn, uint32_t cookie)
+{
+    uint32_t slot = tcp_syn_cookie_slot(ws);
+
+    if ((cookie >> TCP_SYN_COOKIE_HASH_BITS) != (slot & TCP_SYN_COOKIE_SLOT_MASK)) {
+        slot--;
+    }
+
+    return cookie == tcp_syn_cookie_make(&ws->socket_table, saddr, daddr, th, isn, slot);
+}
+
+static inline void tcp_syn_cookie_reply(struct work_space *ws, struct rte_mbuf *m, struct iphdr *iph, struct tcphdr *th)
+{
+    uint32_t saddr = 0;
+    uint32_t daddr = 0;
+    uint32_t isn = ntohl(th->th_seq);
+    struct socket *sk = NULL;
+    struct rte_mbuf *m2 = NULL;
+
+    ip_hdr_get_addr_low32(iph, saddr, daddr);
+    sk = socket_hash_syn_cookie(saddr, daddr, th->th_sport, th->th_dport);
+    if (sk == NULL) {
+        net_stats_tcp_drop();
+        mbuf_free2(m);
+        return;
+    }
+
+    tcp_flags_rx_count(TH_SYN);
+    sk->snd_nxt = tcp_syn_cookie_make(&ws->socket_table, saddr, daddr, th, isn, tcp_syn_cookie_slot(ws));
+    sk->snd_una = sk->snd_nxt;
+    sk->rcv_nxt = isn + 1;
+#ifdef HTTP_PARSE
+    if (ws->timestamps) {
+        tcp_ts_recent(ws, sk, th);
+    }
+#endif
+
+    tcp_flags_tx_count(TH_SYN | TH_ACK);
+    m2 = tcp_new_packet(ws, sk, TH_SYN | TH_ACK);
+    if (m2) {
+        work_space_tx_send_tcp(ws, m2);
+    }
+    mbuf_free2(m);
+}
+
+/* the socket of a handshake ack with a valid cookie, as if it had sent the syn-ack */
+static inline struct socket *tcp_syn_cookie_accept(struct work_space *ws, struct iphdr *iph, struct tcphdr *th)
+{
+    uint32_t saddr = 0;
+    uint32_t daddr = 0;
+    uint32_t ack = ntohl(th->th_ack);
+    uint32_t seq = ntohl(th->th_seq);
+    struct socket *sk = NULL;
+
+    if ((th->th_flags & (TH_SYN | TH_ACK | TH_RST)) != TH_ACK) {
+        return NULL;
+    }
+
+    ip_hdr_get_addr_low32(iph, saddr, daddr);
+    if (!tcp_syn_cookie_check(ws, saddr, daddr, th, seq - 1, ack - 1)) {
+        return NULL;
+    }
+
+    sk = socket_hash_insert(socket_hash_tuple(saddr, daddr, th->th_sport, th->th_dport),
+            saddr, daddr, th->th_sport, th->th_dport);
+    if (sk == NULL) {
+        return NULL;
+    }
+
+    /* the syn-ack is acked, so no retransmit timer and no rtt sample */
+    socket_server_open(&ws->socket_table, sk, th);
+    sk->snd_nxt = ack;
+    sk->snd_una = ack;
+    sk->rcv_nxt = seq;
+#ifdef HTTP_PARSE
+    if (ws->timestamps) {
+        tcp_ts_recent(ws, sk, th);
+    }
+#endif
+
+    return sk;
+}
+
 static inline void tcp_server_process(struct work_space *ws, struct rte_mbuf *m)
 {
     struct iphdr *iph = mbuf_ip_hdr(m);
@@ -912,6 +1800,13 @@ static inline void tcp_server_process(struct work_space *ws, struct rte_mbuf *m)
     struct socket *sk = NULL;
 
     sk = socket_server_lookup(&ws->socket_table, iph, th);
+    if (unlikely(sk == NULL) && ws->socket_table.syn_cookie) {
+        if (flags == TH_SYN) {
+            return tcp_syn_cookie_reply(ws, m, iph, th);
+        }
+        sk = tcp_syn_cookie_accept(ws, iph, th);
+    }
+
     if (unlikely(sk == NULL)) {
         if (ws->kni && work_space_is_local_addr(ws, m)) {
             return kni_recv(ws, m);
@@ -951,6 +1846,23 @@ static inline void tcp_server_process(struct work_space *ws, struct rte_mbuf *m)
     }
 }
 
+#ifdef HTTP_PARSE
+/* deliver the queued segments that rcv_nxt has reached */
+static inline void tcp_client_reorder_run(struct work_space *ws, struct socket *sk)
+{
+    struct rte_mbuf *m = NULL;
+    struct socket_cold *skc = socket_cold_get(&ws->socket_table, sk);
+
+    while ((sk->state == SK_ESTABLISHED) && ((m = tcp_reorder_pop(ws, skc, sk->rcv_nxt)) != NULL)) {
+        tcp_client_process_data(ws, sk, m, mbuf_ip_hdr(m), mbuf_tcp_hdr(m), true);
+    }
+
+    if (sk->state != SK_ESTABLISHED) {
+        tcp_reorder_free(ws, skc);
+    }
+}
+#endif
+
 static inline void tcp_client_process(struct work_space *ws, struct rte_mbuf *m)
 {
     struct iphdr *iph = mbuf_ip_hdr(m);
@@ -985,7 +1897,13 @@ static inline void tcp_client_process(struct work_space *ws, struct rte_mbuf *m)
 
     tcp_flags_rx_count(flags);
     if (((flags & (TH_SYN | TH_RST)) == 0) && (flags & TH_ACK)) {
-        return tcp_client_process_data(ws, sk, m, iph, th);
+        tcp_client_process_data(ws, sk, m, iph, th, false);
+#ifdef HTTP_PARSE
+        if (unlikely(ws->reorder != NULL)) {
+            tcp_client_reorder_run(ws, sk);
+        }
+#endif
+        return;
     } else if (flags == (TH_SYN | TH_ACK)) {
         return tcp_client_process_syn_ack(ws, sk, m, th);
     } else if (flags & TH_RST) {
@@ -1035,6 +1953,13 @@ static inline int tcp_client_launch(struct work_space *ws)
             continue;
         }
 
+#ifdef HTTP_PARSE
+        /* closed by a timer with segments still queued */
+        if (unlikely(ws->reorder != NULL)) {
+            tcp_reorder_free(ws, socket_cold_get(&ws->socket_table, sk));
+        }
+#endif
+
         tcp_reply(ws, sk, TH_SYN);
         if (ws->flood) {
             if (sk->keepalive) {
@@ -1054,9 +1979,9 @@ static int tcp_client_socket_timer_process(struct work_space *ws)
     struct socket_timer *rt_timer = &g_retransmit_timer;
     struct socket_timer *kp_timer = &g_keepalive_timer;
 
-    socket_timer_run(ws, rt_timer, g_config.retransmit_timeout, tcp_do_retransmit);
+    socket_timer_run(ws, rt_timer, tcp_do_retransmit, SOCKET_TIMER_BUDGET);
     if (g_config.keepalive) {
-        socket_timer_run(ws, kp_timer, g_config.keepalive_request_interval, tcp_do_keepalive);
+        socket_timer_run(ws, kp_timer, tcp_do_keepalive, SOCKET_TIMER_BUDGET);
     }
 
     return 0;
@@ -1064,12 +1989,10 @@ static int tcp_client_socket_timer_process(struct work_space *ws)
 
 static inline int tcp_server_socket_timer_process(struct work_space *ws)
 {
-    uint64_t timeout = 0;
     struct socket_timer *rt_timer = &g_retransmit_timer;
 
-    timeout = g_config.retransmit_timeout + (g_config.retransmit_timeout / 10);
-    /* server delays sending by 0.1s to avoid simultaneous retransmission */
-    socket_timer_run(ws, rt_timer, timeout, tcp_do_retransmit);
+    /* see socket_retransmit_timeout() */
+    socket_timer_run(ws, rt_timer, tcp_do_retransmit, SOCKET_TIMER_BUDGET);
     return 0;
 }
 
@@ -1103,6 +2026,27 @@ static void tcp_client_run_loop_vxlan(struct work_space *ws)
     client_loop(ws, vxlan_input, tcp_client_process, udp_drop, tcp_client_socket_timer_process, tcp_client_launch);
 }
 
+/* a tso packet must fit in an ip packet, and in the descriptors of the nic */
+static void tcp_init_tso(struct work_space *ws)
+{
+    struct mbuf_data *mdata = &ws->tcp_data.data;
+    int num = 0;
+
+    if (mdata->data_len > 0) {
+        num = (UINT16_MAX - mdata->l3_len - mdata->l4_len) / mdata->data_len;
+    }
+
+    if ((g_dev_tx_tso_seg_max > 0) && (num > g_dev_tx_tso_seg_max)) {
+        num = g_dev_tx_tso_seg_max;
+    }
+
+    if (num < 2) {
+        ws->tso = 0;
+        return;
+    }
+    ws->tso_seg_max = num;
+}
+
 int tcp_init(struct work_space *ws)
 {
     const char *data = NULL;
@@ -1143,6 +2087,18 @@ int tcp_init(struct work_space *ws)
         return -1;
     }
 
+    if (ws->tso) {
+        tcp_init_tso(ws);
+    }
+
+    if (ws->payload_object) {
+        payload_object_init(ws->id);
+    }
+
+    if (tcp_reorder_init(ws) < 0) {
+        return -1;
+    }
+
     return 0;
 }
 
@@ -1158,25 +2114,17 @@ void tcp_drop(__rte_unused struct work_space *ws, struct rte_mbuf *m)
 }
 
 #ifdef HTTP_PARSE
-int tcp_ack_delay_flush(struct work_space *ws)
+int tcp_ack_delay_run(struct work_space *ws)
 {
-    int i = 0;
-    struct socket *sk = NULL;
+    int num = 0;
+    uint64_t now = work_space_tsc(ws);
 
-    for (i = 0; i < ws->ack_delay.next; i++) {
-        sk = ws->ack_delay.sockets[i];
-        if (sk->http_ack) {
-            sk->http_ack = 0;
-            if (sk->state == SK_ESTABLISHED) {
-                tcp_reply(ws, sk, TH_ACK);
-            }
-       }
+    while ((ws->ack_delay.head != ws->ack_delay.tail)
+            && (ws->ack_delay.fifo[ws->ack_delay.head & TCP_ACK_DELAY_MASK].deadline <= now)) {
+        tcp_ack_delay_pop(ws);
+        num++;
     }
 
-    if (ws->ack_delay.next > 0) {
-        ws->ack_delay.next = 0;
-    }
-
-    return 0;
+    return num;
 }
 #endif
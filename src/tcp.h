@@ -35,9 +35,9 @@ int tcp_init(struct work_space *ws);
 void tcp_drop(__rte_unused struct work_space *ws, struct rte_mbuf *m);
 
 #ifdef HTTP_PARSE
-int tcp_ack_delay_flush(struct work_space *ws);
+int tcp_ack_delay_run(struct work_space *ws);
 #else
-#define tcp_ack_delay_flush(ws) do{}while(0)
+#define tcp_ack_delay_run(ws) 0
 #endif
 
 #endif
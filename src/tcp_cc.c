@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "tcp_cc.h"
+
+#include <string.h>
+
+#include "socket.h"
+#include "tick.h"
+
+#ifdef HTTP_PARSE
+static void tcp_cc_reset(struct socket_cold *skc)
+{
+    skc->cwnd = TCP_CC_INIT_CWND;
+    skc->cwnd_cnt = 0;
+    skc->ssthresh = TCP_CC_SSTHRESH_MAX;
+    skc->w_max = 0;
+    skc->epoch_ms = 0;
+    skc->k_ms = 0;
+}
+
+/* slow start, returns the segments left for congestion avoidance */
+static uint32_t tcp_cc_slow_start(struct socket_cold *skc, uint32_t acked)
+{
+    uint32_t cwnd = skc->cwnd + acked;
+
+    if (cwnd > skc->ssthresh) {
+        cwnd = skc->ssthresh;
+    }
+
+    acked -= cwnd - skc->cwnd;
+    skc->cwnd = cwnd;
+    return acked;
+}
+
+/* one more segment for every 'cnt' segments acked */
+static void tcp_cc_increase(struct socket_cold *skc, uint32_t cnt, uint32_t acked)
+{
+    uint32_t total = skc->cwnd_cnt + acked;
+
+    if (cnt == 0) {
+        cnt = 1;
+    }
+
+    while ((total >= cnt) && (skc->cwnd < TCP_CC_SSTHRESH_MAX)) {
+        total -= cnt;
+        skc->cwnd++;
+    }
+
+    if (total > TCP_CC_SSTHRESH_MAX) {
+        total = 0;
+    }
+    skc->cwnd_cnt = total;
+}
+
+/* RFC 6582 */
+static void tcp_newreno_ack(struct socket_cold *skc, uint32_t acked, __rte_unused uint64_t now_tsc)
+{
+    if (skc->cwnd < skc->ssthresh) {
+        acked = tcp_cc_slow_start(skc, acked);
+        if (acked == 0) {
+            return;
+        }
+    }
+
+    tcp_cc_increase(skc, skc->cwnd, acked);
+}
+
+static void tcp_newreno_loss(struct socket_cold *skc)
+{
+    skc->ssthresh = RTE_MAX(skc->cwnd / 2, 2);
+    skc->cwnd = skc->ssthresh;
+    skc->cwnd_cnt = 0;
+}
+
+static void tcp_newreno_timeout(struct socket_cold *skc)
+{
+    skc->ssthresh = RTE_MAX(skc->cwnd / 2, 2);
+    skc->cwnd = 1;
+    skc->cwnd_cnt = 0;
+}
+
+/*
+ * RFC 8312, W(t) = C * (t - K)^3 + Wmax, C = 0.4, beta = 0.7.
+ * t and K are in milliseconds, so C becomes 4 / 10^10.
+ * */
+#define CUBIC_DELTA_MAX     (1 << 20)
+
+/* Hacker's Delight, icbrt64 */
+static uint32_t tcp_cubic_root(uint64_t a)
+{
+    int s = 0;
+    uint64_t x = 0;
+    uint64_t b = 0;
+
+    for (s = 63; s >= 0; s -= 3) {
+        x <<= 1;
+        b = 3 * x * (x + 1) + 1;
+        if ((a >> s) >= b) {
+            a -= b << s;
+            x++;
+        }
+    }
+
+    return (uint32_t)x;
+}
+
+static void tcp_cubic_ack(struct socket_cold *skc, uint32_t acked, uint64_t now_tsc)
+{
+    uint32_t now_ms = now_tsc / (TSC_PER_SEC / 1000);
+    int64_t delta = 0;
+    int64_t target = 0;
+    uint32_t cnt = 0;
+
+    if (skc->cwnd < skc->ssthresh) {
+        acked = tcp_cc_slow_start(skc, acked);
+        if (acked == 0) {
+            return;
+        }
+    }
+
+    if (skc->epoch_ms == 0) {
+        skc->epoch_ms = now_ms | 1;
+        if (skc->cwnd < skc->w_max) {
+            skc->k_ms = tcp_cubic_root((uint64_t)(skc->w_max - skc->cwnd) * 2500000000ul);
+        } else {
+            skc->k_ms = 0;
+            skc->w_max = skc->cwnd;
+        }
+    }
+
+    delta = (int64_t)(uint32_t)(now_ms - skc->epoch_ms) - skc->k_ms;
+    delta = RTE_MIN(RTE_MAX(delta, -CUBIC_DELTA_MAX), CUBIC_DELTA_MAX);
+    target = skc->w_max + (4 * delta * delta * delta) / 10000000000l;
+
+    if (target > skc->cwnd) {
+        cnt = skc->cwnd / (target - skc->cwnd);
+    } else {
+        /* plateau around Wmax */
+        cnt = 100 * skc->cwnd;
+    }
+
+    tcp_cc_increase(skc, cnt, acked);
+}
+
+static void tcp_cubic_loss(struct socket_cold *skc)
+{
+    skc->epoch_ms = 0;
+    /* fast convergence */
+    if (skc->cwnd < skc->w_max) {
+        skc->w_max = skc->cwnd * 17 / 20;
+    } else {
+        skc->w_max = skc->cwnd;
+    }
+
+    skc->cwnd = RTE_MAX(skc->cwnd * 7 / 10, 2);
+    skc->ssthresh = skc->cwnd;
+    skc->cwnd_cnt = 0;
+}
+
+static void tcp_cubic_timeout(struct socket_cold *skc)
+{
+    tcp_cubic_loss(skc);
+    skc->cwnd = 1;
+}
+
+static const struct tcp_cc_ops g_tcp_cc_ops[] = {
+    [TCP_CC_NONE] = {"none", NULL, NULL, NULL, NULL},
+    {"newreno", tcp_cc_reset, tcp_newreno_ack, tcp_newreno_loss, tcp_newreno_timeout},
+    {"cubic", tcp_cc_reset, tcp_cubic_ack, tcp_cubic_loss, tcp_cubic_timeout},
+};
+
+#define TCP_CC_NUM  (int)(sizeof(g_tcp_cc_ops) / sizeof(struct tcp_cc_ops))
+
+int tcp_cc_find(const char *name)
+{
+    int i = 0;
+
+    for (i = 1; i < TCP_CC_NUM; i++) {
+        if (strcmp(g_tcp_cc_ops[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const struct tcp_cc_ops *tcp_cc_get(int id)
+{
+    if ((id <= TCP_CC_NONE) || (id >= TCP_CC_NUM)) {
+        return NULL;
+    }
+
+    return &g_tcp_cc_ops[id];
+}
+#else
+int tcp_cc_find(__rte_unused const char *name)
+{
+    return -1;
+}
+
+const struct tcp_cc_ops *tcp_cc_get(__rte_unused int id)
+{
+    return NULL;
+}
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __TCP_CC_H
+#define __TCP_CC_H
+
+#include <stdint.h>
+
+/*
+ * Congestion control of the server's bulk transfer (send_window).
+ * All windows are counted in segments.
+ * */
+#define TCP_CC_NONE         0
+#define TCP_CC_INIT_CWND    10
+#define TCP_CC_SSTHRESH_MAX 0xffff
+
+struct socket_cold;
+
+struct tcp_cc_ops {
+    const char *name;
+    void (*init)(struct socket_cold *skc);
+    /* 'acked' new segments are acknowledged */
+    void (*ack)(struct socket_cold *skc, uint32_t acked, uint64_t now_tsc);
+    /* fast retransmit */
+    void (*loss)(struct socket_cold *skc);
+    void (*timeout)(struct socket_cold *skc);
+};
+
+int tcp_cc_find(const char *name);
+const struct tcp_cc_ops *tcp_cc_get(int id);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "tcp_reorder.h"
+
+#include <stdio.h>
+#include <rte_malloc.h>
+
+#include "config.h"
+
+int tcp_reorder_init(struct work_space *ws)
+{
+    int i = 0;
+    size_t size = 0;
+    struct config *cfg = ws->cfg;
+    struct tcp_reorder_pool *pool = NULL;
+
+    if (cfg->rx_reorder == 0) {
+        return 0;
+    }
+
+    size = sizeof(struct tcp_reorder_pool) + (cfg->rx_reorder_num + 1) * sizeof(struct tcp_reorder);
+    pool = (struct tcp_reorder_pool *)rte_zmalloc_socket("tcp_reorder", size, CACHE_ALIGN_SIZE, rte_socket_id());
+    if (pool == NULL) {
+        printf("Error: rx_reorder allocation failed, memory size %0.2fMB\n", size * 1.0 / (1024 * 1024));
+        return -1;
+    }
+
+    pool->depth = cfg->rx_reorder;
+    for (i = cfg->rx_reorder_num; i > 0; i--) {
+        pool->buffers[i].next = pool->free;
+        pool->free = i;
+    }
+    ws->reorder = pool;
+
+    return 0;
+}
+
+void tcp_reorder_close(struct work_space *ws)
+{
+    if (ws->reorder) {
+        rte_free(ws->reorder);
+        ws->reorder = NULL;
+    }
+}
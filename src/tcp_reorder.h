@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __TCP_REORDER_H
+#define __TCP_REORDER_H
+
+#include <stdint.h>
+#include <rte_mbuf.h>
+
+#include "mbuf.h"
+#include "net_stats.h"
+#include "socket.h"
+#include "work_space.h"
+
+/*
+ * Out-of-order segments of a client socket wait in a buffer of the worker pool,
+ * sorted by sequence, until rcv_nxt reaches them. A socket only holds a buffer
+ * while it has reordered segments.
+ * */
+struct tcp_reorder {
+    uint16_t num;
+    uint16_t next;      /* free list */
+    uint32_t seq[TCP_REORDER_DEPTH_MAX];
+    struct rte_mbuf *mbufs[TCP_REORDER_DEPTH_MAX];
+};
+
+struct tcp_reorder_pool {
+    uint16_t depth;
+    uint16_t free;      /* buffer index, 0 is none */
+    struct tcp_reorder buffers[0];  /* buffers[0] is not used */
+};
+
+int tcp_reorder_init(struct work_space *ws);
+void tcp_reorder_close(struct work_space *ws);
+
+#ifdef HTTP_PARSE
+static inline struct tcp_reorder *tcp_reorder_get(struct tcp_reorder_pool *pool, struct socket_cold *skc)
+{
+    struct tcp_reorder *ro = NULL;
+
+    if (skc->reorder) {
+        return &pool->buffers[skc->reorder];
+    }
+
+    if (pool->free == 0) {
+        return NULL;
+    }
+
+    skc->reorder = pool->free;
+    ro = &pool->buffers[pool->free];
+    pool->free = ro->next;
+    ro->num = 0;
+
+    return ro;
+}
+
+static inline void tcp_reorder_put(struct tcp_reorder_pool *pool, struct socket_cold *skc)
+{
+    struct tcp_reorder *ro = &pool->buffers[skc->reorder];
+
+    ro->next = pool->free;
+    pool->free = skc->reorder;
+    skc->reorder = 0;
+}
+
+/* 0: 'm' is queued, otherwise the caller still owns it */
+static inline int tcp_reorder_insert(struct work_space *ws, struct socket_cold *skc, struct rte_mbuf *m, uint32_t seq)
+{
+    int i = 0;
+    struct tcp_reorder *ro = NULL;
+    struct tcp_reorder_pool *pool = ws->reorder;
+
+    ro = tcp_reorder_get(pool, skc);
+    if (unlikely(ro == NULL) || (ro->num >= pool->depth)) {
+        net_stats_tcp_reorder_drop();
+        return -1;
+    }
+
+    i = ro->num;
+    while ((i > 0) && ((int)(seq - ro->seq[i - 1]) < 0)) {
+        i--;
+    }
+
+    /* a retransmission of a queued segment */
+    if ((i > 0) && (seq == ro->seq[i - 1])) {
+        net_stats_tcp_reorder_drop();
+        return -1;
+    }
+
+    memmove(&ro->seq[i + 1], &ro->seq[i], (ro->num - i) * sizeof(uint32_t));
+    memmove(&ro->mbufs[i + 1], &ro->mbufs[i], (ro->num - i) * sizeof(struct rte_mbuf *));
+    ro->seq[i] = seq;
+    ro->mbufs[i] = m;
+    ro->num++;
+    net_stats_tcp_reorder(ro->num);
+
+    return 0;
+}
+
+/* the queued segment at 'rcv_nxt', older ones were retransmitted and are dropped */
+static inline struct rte_mbuf *tcp_reorder_pop(struct work_space *ws, struct socket_cold *skc, uint32_t rcv_nxt)
+{
+    int i = 0;
+    struct rte_mbuf *m = NULL;
+    struct tcp_reorder *ro = NULL;
+
+    if (likely(skc->reorder == 0)) {
+        return NULL;
+    }
+
+    ro = &ws->reorder->buffers[skc->reorder];
+    while ((i < ro->num) && ((int)(ro->seq[i] - rcv_nxt) < 0)) {
+        mbuf_free2(ro->mbufs[i]);
+        i++;
+    }
+
+    if ((i < ro->num) && (ro->seq[i] == rcv_nxt)) {
+        m = ro->mbufs[i];
+        i++;
+    }
+
+    if (i > 0) {
+        ro->num -= i;
+        memmove(&ro->seq[0], &ro->seq[i], ro->num * sizeof(uint32_t));
+        memmove(&ro->mbufs[0], &ro->mbufs[i], ro->num * sizeof(struct rte_mbuf *));
+    }
+
+    if (ro->num == 0) {
+        tcp_reorder_put(ws->reorder, skc);
+    }
+
+    return m;
+}
+
+static inline void tcp_reorder_free(struct work_space *ws, struct socket_cold *skc)
+{
+    int i = 0;
+    struct tcp_reorder *ro = NULL;
+
+    if (likely(skc->reorder == 0)) {
+        return;
+    }
+
+    ro = &ws->reorder->buffers[skc->reorder];
+    for (i = 0; i < ro->num; i++) {
+        mbuf_free2(ro->mbufs[i]);
+    }
+    tcp_reorder_put(ws->reorder, skc);
+}
+#endif
+
+#endif
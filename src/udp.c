@@ -30,6 +30,9 @@
 #include "loop.h"
 #include "socket_timer.h"
 #include "csum.h"
+#include "dns.h"
+
+#include <rte_byteorder.h>
 
 static char g_udp_data[THREAD_NUM_MAX][MBUF_DATA_SIZE];
 
@@ -82,6 +85,126 @@ static inline void udp_change_dip(struct work_space *ws, struct iphdr *iph, stru
     }
 }
 
+/* a jump this far is a restarted sender */
+#define UDP_SEQ_RESTART     (1 << 16)
+#define UDP_SEQ_MAP_BITS    64
+
+/* sequences are per tuple, they go on when a socket is reopened */
+static inline struct udp_seq_flow *udp_seq_flow_get(struct work_space *ws, struct socket *sk)
+{
+    return &ws->socket_table.udp_seq[socket_pool_index(&ws->socket_table, sk)];
+}
+
+static inline void udp_seq_tx(struct work_space *ws, struct socket *sk, struct udphdr *uh)
+{
+    struct udp_seq_hdr *hdr = (struct udp_seq_hdr *)(uh + 1);
+    struct udp_seq_flow *flow = udp_seq_flow_get(ws, sk);
+
+    hdr->flow = htonl(socket_pool_index(&ws->socket_table, sk));
+    hdr->seq = htonl(flow->tx_seq++);
+    hdr->tsc = rte_cpu_to_be_64(rte_rdtsc());
+}
+
+/* RFC 3550 A.8, transit times are in units of (1 << SOCKET_RTT_SHIFT) tsc */
+static inline void udp_seq_jitter(struct udp_seq_flow *flow, uint64_t now, uint64_t tsc)
+{
+    int32_t delta = 0;
+    uint32_t transit = (uint32_t)((now - tsc) >> SOCKET_RTT_SHIFT);
+
+    if (flow->transit) {
+        delta = (int32_t)(transit - flow->transit);
+        if (delta < 0) {
+            delta = -delta;
+        }
+        flow->jitter += delta - ((flow->jitter + 8) >> 4);
+        net_stats_udp_jitter((uint64_t)(flow->jitter >> 4) << SOCKET_RTT_SHIFT, now - tsc);
+    }
+    flow->transit = transit;
+}
+
+static inline void udp_seq_rx(struct work_space *ws, struct socket *sk, struct rte_mbuf *m)
+{
+    int32_t diff = 0;
+    uint32_t seq = 0;
+    uint32_t bit = 0;
+    uint64_t tsc = 0;
+    uint64_t now = rte_rdtsc();
+    struct udphdr *uh = mbuf_udp_hdr(m);
+    struct udp_seq_hdr *hdr = (struct udp_seq_hdr *)(uh + 1);
+    struct udp_seq_flow *flow = udp_seq_flow_get(ws, sk);
+
+    if (unlikely((ntohs(uh->len) < sizeof(struct udphdr) + sizeof(struct udp_seq_hdr)) ||
+        (rte_pktmbuf_data_len(m) < ((uint8_t *)(hdr + 1) - rte_pktmbuf_mtod(m, uint8_t *))))) {
+        return;
+    }
+
+    seq = ntohl(hdr->seq);
+    tsc = rte_be_to_cpu_64(hdr->tsc);
+    diff = (int32_t)(seq - flow->rx_seq);
+    if (unlikely((diff >= UDP_SEQ_RESTART) || (diff <= -UDP_SEQ_RESTART))) {
+        /* the peer restarted, our own tx_seq goes on */
+        flow->rx_seq = seq;
+        flow->rx_map = 0;
+        flow->transit = 0;
+        flow->jitter = 0;
+        diff = 0;
+    }
+
+    if (diff >= 0) {
+        if (diff) {
+            net_stats_udp_seq_gap(diff);
+        }
+
+        if (diff + 1 >= UDP_SEQ_MAP_BITS) {
+            flow->rx_map = 1;
+        } else {
+            flow->rx_map = (flow->rx_map << (diff + 1)) | 1;
+        }
+        flow->rx_seq = seq + 1;
+    } else {
+        bit = -diff - 1;
+        if (bit < UDP_SEQ_MAP_BITS) {
+            if (flow->rx_map & (1ull << bit)) {
+                net_stats_udp_seq_dup();
+                return;
+            }
+            flow->rx_map |= 1ull << bit;
+        }
+        net_stats_udp_seq_late();
+    }
+
+    udp_seq_jitter(flow, now, tsc);
+}
+
+/* the pseudo header checksum of sk->csum_udp is for the length of the template */
+static inline void udp_set_data_len(struct work_space *ws, struct iphdr *iph, struct udphdr *uh, uint16_t data_len)
+{
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+
+    uh->len = htons(sizeof(struct udphdr) + data_len);
+    if (ws->ipv6) {
+        ip6h->ip6_plen = uh->len;
+        uh->check = RTE_IPV6_PHDR_CKSUM(ip6h, 0);
+    } else {
+        iph->tot_len = htons(sizeof(struct iphdr) + sizeof(struct udphdr) + data_len);
+        uh->check = RTE_IPV4_PHDR_CKSUM(iph, 0);
+    }
+}
+
+/* the template payload is as long as the longest query */
+static inline void udp_dns_query(struct work_space *ws, struct rte_mbuf *m, struct iphdr *iph, struct udphdr *uh)
+{
+    uint16_t len = 0;
+
+    len = dns_query_write((uint8_t *)(uh + 1), ws->dns_id++, ws->dns_name);
+    if (++ws->dns_name == g_dns_names.num) {
+        ws->dns_name = 0;
+    }
+
+    rte_pktmbuf_trim(m, ws->udp.data.data_len - len);
+    udp_set_data_len(ws, iph, uh, len);
+}
+
 static inline struct rte_mbuf *udp_new_packet(struct work_space *ws, struct socket *sk)
 {
     struct rte_mbuf *m = NULL;
@@ -97,7 +220,7 @@ static inline struct rte_mbuf *udp_new_packet(struct work_space *ws, struct sock
 
     if (ws->vxlan) {
         vxhs = (struct vxlan_headers *)mbuf_eth_hdr(m);
-        vxhs->uh.source = (sk->fport + sk->lport + sk->csum_ip) | htons(VXLAN_SPORT_MASK);
+        vxhs->uh.source = (sk->fport + sk->lport + sk->csum_udp) | htons(VXLAN_SPORT_MASK);
 
         iph = (struct iphdr *)((uint8_t *)mbuf_eth_hdr(m) + VXLAN_HEADERS_SIZE + sizeof(struct eth_hdr));
         if (ws->ipv6) {
@@ -105,7 +228,9 @@ static inline struct rte_mbuf *udp_new_packet(struct work_space *ws, struct sock
             uh = (struct udphdr *)((uint8_t *)ip6h + sizeof(struct ip6_hdr));
         } else {
             uh = (struct udphdr *)((uint8_t *)iph + sizeof(struct iphdr));
-            iph->check = csum_update_u16(sk->csum_ip, 0, htons(ws->ip_id));
+            /* udp sockets have no room for the inner ip checksum */
+            iph->check = csum_update_u32(ws->udp_ip_csum, sk->laddr, sk->faddr);
+            iph->check = csum_update_u16(iph->check, 0, htons(ws->ip_id));
         }
     } else {
         iph = mbuf_ip_hdr(m);
@@ -125,6 +250,12 @@ static inline struct rte_mbuf *udp_new_packet(struct work_space *ws, struct sock
     uh->source = sk->lport;
     uh->dest = sk->fport;
     uh->check = sk->csum_udp;
+    if (ws->udp_seq) {
+        udp_seq_tx(ws, sk, uh);
+    }
+    if (ws->dns) {
+        udp_dns_query(ws, m, iph, uh);
+    }
 
     /* only in client mode */
     if (ws->change_dip) {
@@ -134,6 +265,146 @@ static inline struct rte_mbuf *udp_new_packet(struct work_space *ws, struct sock
     return m;
 }
 
+static inline bool udp_reflect_resize(struct rte_mbuf *m, uint16_t pkt_len)
+{
+    uint16_t data_len = rte_pktmbuf_data_len(m);
+
+    if (pkt_len > data_len) {
+        if (unlikely(rte_pktmbuf_append(m, pkt_len - data_len) == NULL)) {
+            return false;
+        }
+    } else if (pkt_len < data_len) {
+        rte_pktmbuf_trim(m, data_len - pkt_len);
+    }
+
+    return true;
+}
+
+/*
+ * Turn the request headers into the reply headers in place: the addresses and the
+ * ports are swapped, tos and df come from the template. The lengths and the checksums
+ * are left to the caller.
+ * */
+static inline void udp_reflect_headers(struct work_space *ws, struct rte_mbuf *m)
+{
+    uint32_t addr = 0;
+    uint16_t port = 0;
+    struct in6_addr addr6;
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+    struct udphdr *uh = mbuf_udp_hdr(m);
+    struct mbuf_data *mdata = &ws->udp.data;
+    const struct iphdr *tiph = (const struct iphdr *)(mdata->data + mdata->l2_len);
+
+    eth_addr_swap(mbuf_eth_hdr(m));
+    if (!ws->ipv6) {
+        iph->tos = tiph->tos;
+        iph->frag_off = tiph->frag_off;
+        iph->id = htons(ws->ip_id++);
+        addr = iph->saddr;
+        iph->saddr = iph->daddr;
+        iph->daddr = addr;
+    } else {
+        ip6h->ip6_flow = ((const struct ip6_hdr *)tiph)->ip6_flow;
+        addr6 = ip6h->ip6_src;
+        ip6h->ip6_src = ip6h->ip6_dst;
+        ip6h->ip6_dst = addr6;
+    }
+
+    port = uh->source;
+    uh->source = uh->dest;
+    uh->dest = port;
+}
+
+/*
+ * The reply of a server reuses the request mbuf, like icmp_process(): no mempool
+ * get/put. A request as long as the template keeps its payload, and the pseudo
+ * header checksum of the socket is still right. Otherwise the template payload is
+ * copied.
+ * */
+static inline bool udp_reflect(struct work_space *ws, struct socket *sk, struct rte_mbuf *m)
+{
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct ip6_hdr *ip6h = (struct ip6_hdr *)iph;
+    struct udphdr *uh = mbuf_udp_hdr(m);
+    struct mbuf_data *mdata = &ws->udp.data;
+    uint16_t hdr_len = mdata->l2_len + mdata->l3_len + mdata->l4_len;
+    uint16_t len = ntohs(uh->len);
+
+    if (unlikely(m->nb_segs != 1) || ((!ws->ipv6) && unlikely(iph->ihl != 5))) {
+        return false;
+    }
+
+    if (unlikely((len < sizeof(struct udphdr)) ||
+        (hdr_len + len - sizeof(struct udphdr) > rte_pktmbuf_data_len(m)))) {
+        return false;
+    }
+
+    if (len == mdata->l4_len + mdata->data_len) {
+        /* drop the ethernet padding */
+        udp_reflect_resize(m, mdata->total_len);
+    } else {
+        if (unlikely(!udp_reflect_resize(m, mdata->total_len))) {
+            return false;
+        }
+
+        memcpy(uh + 1, mdata->data + hdr_len, mdata->data_len);
+        uh->len = htons(mdata->l4_len + mdata->data_len);
+        if (ws->ipv6) {
+            ip6h->ip6_plen = uh->len;
+        } else {
+            iph->tot_len = htons(mdata->l3_len + mdata->l4_len + mdata->data_len);
+        }
+    }
+
+    udp_reflect_headers(ws, m);
+    uh->check = sk->csum_udp;
+    if (ws->udp_seq) {
+        udp_seq_tx(ws, sk, uh);
+    }
+
+    /* rx offload flags */
+    m->ol_flags = 0;
+    work_space_tx_send_udp(ws, m);
+
+    return true;
+}
+
+/* the response is built on the query, only the headers come from the template */
+static inline bool udp_dns_reply(struct work_space *ws, struct rte_mbuf *m)
+{
+    struct iphdr *iph = mbuf_ip_hdr(m);
+    struct udphdr *uh = mbuf_udp_hdr(m);
+    struct mbuf_data *mdata = &ws->udp.data;
+    uint16_t hdr_len = mdata->l2_len + mdata->l3_len + mdata->l4_len;
+    uint16_t data_len = rte_pktmbuf_data_len(m);
+    uint16_t len = ntohs(uh->len);
+    uint16_t room = 0;
+
+    if (unlikely(m->nb_segs != 1) || ((!ws->ipv6) && unlikely(iph->ihl != 5))) {
+        return false;
+    }
+
+    if (unlikely((len < sizeof(struct udphdr)) || (hdr_len + len - sizeof(struct udphdr) > data_len))) {
+        return false;
+    }
+
+    len -= sizeof(struct udphdr);
+    room = data_len + rte_pktmbuf_tailroom(m) - hdr_len;
+    len = dns_reply((uint8_t *)(uh + 1), len, room, g_config.dns_answers);
+    if (unlikely(len == 0) || unlikely(!udp_reflect_resize(m, hdr_len + len))) {
+        return false;
+    }
+
+    udp_reflect_headers(ws, m);
+    udp_set_data_len(ws, iph, uh, len);
+
+    m->ol_flags = 0;
+    work_space_tx_send_udp(ws, m);
+
+    return true;
+}
+
 static inline struct rte_mbuf* udp_send(struct work_space *ws, struct socket *sk)
 {
     struct rte_mbuf *m = NULL;
@@ -159,7 +430,6 @@ static inline void udp_retransmit_handler(__rte_unused struct work_space *ws, st
 static inline void udp_send_request(struct work_space *ws, struct socket *sk)
 {
     sk->state = SK_SYN_SENT;
-    sk->keepalive_request_num++;
     udp_send(ws, sk);
 }
 
@@ -184,7 +454,7 @@ static void udp_socket_keepalive_timer_handler(struct work_space *ws, struct soc
             pipeline--;
         } while (pipeline > 0);
         if (g_config.keepalive_request_interval) {
-            socket_start_keepalive_timer(sk, work_space_tsc(ws));
+            socket_start_keepalive_timer_force(sk, work_space_tsc(ws));
         }
     }
 }
@@ -208,6 +478,10 @@ static void udp_client_process(struct work_space *ws, struct rte_mbuf *m)
     } else {
         goto out;
     }
+
+    if (ws->udp_seq) {
+        udp_seq_rx(ws, sk, m);
+    }
     if (sk->keepalive == 0) {
         net_stats_rtt(ws, sk);
         socket_close(sk);
@@ -237,6 +511,21 @@ static void udp_server_process(struct work_space *ws, struct rte_mbuf *m)
         goto out;
     }
 
+    if (ws->udp_seq) {
+        udp_seq_rx(ws, sk, m);
+    }
+
+    if (ws->dns) {
+        if (likely(udp_dns_reply(ws, m))) {
+            return;
+        }
+        goto out;
+    }
+
+    if (likely(!ws->vxlan) && udp_reflect(ws, sk, m)) {
+        return;
+    }
+
     udp_send(ws, sk);
     mbuf_free(m);
     return;
@@ -255,7 +544,7 @@ static int udp_client_launch(struct work_space *ws)
 
     num = work_space_client_launch_num(ws);
     for (i = 0; i < num; i++) {
-        sk = socket_client_open(&ws->socket_table, work_space_tsc(ws));
+        sk = socket_client_open_udp(&ws->socket_table, work_space_tsc(ws));
         if (unlikely(sk == NULL)) {
             continue;
         }
@@ -267,7 +556,7 @@ static int udp_client_launch(struct work_space *ws)
         if (sk->keepalive) {
             if (g_config.keepalive_request_interval) {
                 /* for rtt calculationn */
-                socket_start_keepalive_timer(sk, work_space_tsc(ws));
+                socket_start_keepalive_timer_force(sk, work_space_tsc(ws));
             }
         } else if (ws->flood) {
             socket_close(sk);
@@ -285,9 +574,9 @@ static inline int udp_client_socket_timer_process(struct work_space *ws)
     struct socket_timer *kp_timer = &g_keepalive_timer;
 
     if (g_config.keepalive) {
-        socket_timer_run(ws, kp_timer, g_config.keepalive_request_interval, udp_socket_keepalive_timer_handler);
+        socket_timer_run(ws, kp_timer, udp_socket_keepalive_timer_handler, SOCKET_TIMER_BUDGET);
     } else {
-        socket_timer_run(ws, rt_timer, g_config.retransmit_timeout, udp_retransmit_handler);
+        socket_timer_run(ws, rt_timer, udp_retransmit_handler, SOCKET_TIMER_BUDGET);
     }
     return 0;
 }
@@ -351,7 +640,20 @@ int udp_init(struct work_space *ws)
         }
     }
 
-    return mbuf_cache_init_udp(&ws->udp, ws, "udp", g_udp_data[ws->id]);
+    if (mbuf_cache_init_udp(&ws->udp, ws, "udp", g_udp_data[ws->id]) < 0) {
+        return -1;
+    }
+
+    /* workers start at different qnames */
+    if (ws->dns && g_dns_names.num) {
+        ws->dns_name = (uint64_t)g_dns_names.num * ws->id / g_config.cpu_num;
+    }
+
+    if (ws->vxlan && (!ws->ipv6)) {
+        ws->udp_ip_csum = csum_inner_ip_template(&ws->udp);
+    }
+
+    return 0;
 }
 
 void udp_drop(__rte_unused struct work_space *ws, struct rte_mbuf *m)
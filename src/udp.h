@@ -21,10 +21,30 @@
 #ifndef __UDP_H
 #define __UDP_H
 
+#include <stdint.h>
 #include <netinet/udp.h>
 #include <rte_mbuf.h>
 #include <rte_common.h>
 
+/*
+ * 'udp_seq': the first bytes of every payload, written at tx time.
+ * The receiver counts loss, reordering, duplication and jitter per flow.
+ * */
+struct udp_seq_hdr {
+    uint32_t flow;
+    uint32_t seq;
+    uint64_t tsc;
+} __attribute__((__packed__));
+
+/* in an array parallel to the socket pool */
+struct udp_seq_flow {
+    uint32_t tx_seq;
+    uint32_t rx_seq;        /* next expected */
+    uint64_t rx_map;        /* bit i: rx_seq - 1 - i was received */
+    uint32_t transit;       /* of the last packet, in units of (1 << SOCKET_RTT_SHIFT) tsc */
+    uint32_t jitter;        /* RFC 3550, scaled by 16 */
+};
+
 struct work_space;
 struct config;
 void udp_set_payload(struct config *cfg, char *payload);
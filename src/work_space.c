@@ -27,6 +27,7 @@
 #include "server.h"
 #include "udp.h"
 #include "lldp.h"
+#include "tcp_reorder.h"
 
 #include <rte_cycles.h>
 #include <rte_mempool.h>
@@ -36,6 +37,7 @@
 
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -44,11 +46,15 @@
 #define MAP_HUGE_1GB (30 << 26)
 #endif
 
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
 __thread struct work_space *g_work_space;
 static struct work_space *g_work_space_all[THREAD_NUM_MAX];
 static rte_atomic32_t g_wait_count;
 
-static void work_space_init_rss(struct work_space *ws);
+static int work_space_init_rss(struct work_space *ws);
 
 void work_space_wait_start(void)
 {
@@ -173,29 +179,149 @@ static int work_space_init_change_dip(struct work_space *ws, struct config *cfg)
     return 0;
 }
 
+/* prefer the numa node of this lcore for pages not faulted in yet */
+static void work_space_mbind(void *p, size_t size)
+{
+    int node = rte_socket_id();
+    unsigned long mask = 0;
+
+    if ((node < 0) || (node >= (int)(sizeof(mask) * 8))) {
+        return;
+    }
+
+    mask = 1ul << node;
+    if (syscall(SYS_mbind, p, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) != 0) {
+        printf("Warning: mbind to numa node %d failed, errno %d\n", node, errno);
+    }
+}
+
+/*
+ * sparse socket table: reserve the address space only, pages are faulted in
+ * when a chunk of sockets is initialized on first touch.
+ * */
+static struct work_space *work_space_alloc_sparse(size_t size)
+{
+    void *p = NULL;
+    struct work_space *ws = NULL;
+
+    p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    madvise(p, size, MADV_HUGEPAGE);
+    work_space_mbind(p, size);
+    ws = (struct work_space *)p;
+    ws->mmap = 1;
+    ws->mmap_size = size;
+    return ws;
+}
+
+static size_t work_space_socket_cold_size(struct config *cfg, uint32_t socket_num)
+{
+#ifdef HTTP_PARSE
+    if (cfg->protocol == IPPROTO_TCP) {
+        return socket_num * sizeof(struct socket_cold);
+    }
+#endif
+    if (cfg->udp_seq) {
+        return socket_num * sizeof(struct udp_seq_flow);
+    }
+    return 0;
+}
+
+static uint8_t work_space_socket_shift(struct config *cfg)
+{
+    if (cfg->protocol == IPPROTO_UDP) {
+        return SOCKET_SHIFT_UDP;
+    }
+
+    return SOCKET_SHIFT_TCP;
+}
+
+/* the last udp socket is still a 'struct socket' */
+static size_t work_space_socket_pool_size(struct config *cfg, uint32_t socket_num)
+{
+    return ((size_t)socket_num << work_space_socket_shift(cfg)) + sizeof(struct socket);
+}
+
+/* the last udp socket of the pool also has a deadline */
+static size_t work_space_timer_deadline_size(uint32_t socket_num)
+{
+    return ((size_t)socket_num + 1) * sizeof(uint64_t);
+}
+
+/* [struct work_space][sockets][timer deadlines][cold sockets][chunk map] */
+static void work_space_init_socket_pool(struct work_space *ws, struct config *cfg, uint32_t socket_num,
+    size_t cold_size)
+{
+    struct socket_table *st = &ws->socket_table;
+    uint8_t *p = st->socket_pool.base + work_space_socket_pool_size(cfg, socket_num);
+
+    st->socket_shift = work_space_socket_shift(cfg);
+    st->socket_pool.num = socket_num;
+    st->timer_deadline = (uint64_t *)p;
+    p += work_space_timer_deadline_size(socket_num);
+    if (cold_size) {
+        if (cfg->protocol == IPPROTO_TCP) {
+            st->cold = (struct socket_cold *)p;
+        } else {
+            st->udp_seq = (struct udp_seq_flow *)p;
+        }
+        p += cold_size;
+    }
+
+    st->chunk_map = (uint64_t *)p;
+}
+
 static struct work_space *work_space_alloc(struct config *cfg, int id)
 {
     size_t size = 0;
+    size_t cold_size = 0;
     uint32_t socket_num = 0;
     struct work_space *ws = NULL;
     void *p = NULL;
 
     socket_num = config_get_total_socket_num(cfg, id);
-    size = sizeof(struct work_space) + socket_num * sizeof(struct socket);
+    cold_size = work_space_socket_cold_size(cfg, socket_num);
+    size = sizeof(struct work_space) + work_space_socket_pool_size(cfg, socket_num);
+    if (size > SOCKET_NODE_REACH) {
+        printf("Error: too many sockets %u\n", socket_num);
+        return NULL;
+    }
+    size += work_space_timer_deadline_size(socket_num) + cold_size + SOCKET_CHUNK_MAP_SIZE(socket_num);
+
+    if (cfg->socket_table == SOCKET_TABLE_SPARSE) {
+        ws = work_space_alloc_sparse(size);
+        if (ws != NULL) {
+            printf("socket allocation succeeded, sparse, reserved memory size %0.2fGB socket num %u numa node %d.\n",
+                size * 1.0 / (1024 * 1024 * 1024), socket_num, (int)rte_socket_id());
+            ws->mem_size = size;
+            work_space_init_socket_pool(ws, cfg, socket_num, cold_size);
+        } else {
+            printf("Error: socket allocation failed, sparse, reserved memory size %0.2fGB socket num %u.\n",
+                size * 1.0 / (1024 * 1024 * 1024), socket_num);
+        }
+        return ws;
+    }
 
-    ws = (struct work_space *)rte_calloc("work_space", 1, size, CACHE_ALIGN_SIZE);
+    /* the socket table is only touched by this lcore */
+    ws = (struct work_space *)rte_calloc_socket("work_space", 1, size, CACHE_ALIGN_SIZE, rte_socket_id());
     if (ws == NULL) {
         p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|MAP_HUGE_1GB, -1, 0);
         if (p != MAP_FAILED) {
             ws = (struct work_space *)p;
+            work_space_mbind(p, size);
             memset(p, 0, size);
             ws->mmap = 1;
             ws->mmap_size = size;
         }
     }
     if (ws != NULL) {
-        printf("socket allocation succeeded, memory size %0.2fGB socket num %u.\n", size * 1.0 / (1024 * 1024 * 1024), socket_num);
-        ws->socket_table.socket_pool.num = socket_num;
+        printf("socket allocation succeeded, memory size %0.2fGB socket num %u numa node %d.\n",
+            size * 1.0 / (1024 * 1024 * 1024), socket_num, (int)rte_socket_id());
+        ws->mem_size = size;
+        work_space_init_socket_pool(ws, cfg, socket_num, cold_size);
     } else {
         printf("Error: socket allocation failed, memory size %0.2fGB socket num %u.\n", size * 1.0 / (1024 * 1024 * 1024), socket_num);
         printf("Please:\n");
@@ -208,38 +334,133 @@ static struct work_space *work_space_alloc(struct config *cfg, int id)
     return ws;
 }
 
+/* called once all workers are allocated */
+static void work_space_numa_report(void)
+{
+    int i = 0;
+    int node = 0;
+    size_t ws_size[RTE_MAX_NUMA_NODES];
+    struct rte_malloc_socket_stats stats;
+    struct work_space *ws = NULL;
+
+    memset(ws_size, 0, sizeof(ws_size));
+    for (i = 0; i < g_config.cpu_num; i++) {
+        ws = g_work_space_all[i];
+        if ((ws != NULL) && (ws->numa_node >= 0) && (ws->numa_node < RTE_MAX_NUMA_NODES)) {
+            ws_size[ws->numa_node] += ws->mem_size;
+        }
+    }
+
+    for (node = 0; node < RTE_MAX_NUMA_NODES; node++) {
+        memset(&stats, 0, sizeof(stats));
+        rte_malloc_get_socket_stats(node, &stats);
+        if ((ws_size[node] == 0) && (stats.heap_allocsz_bytes == 0)) {
+            continue;
+        }
+        printf("numa node %d: work space %0.2fGB, dpdk heap allocated %0.2fGB\n", node,
+            ws_size[node] * 1.0 / (1024 * 1024 * 1024), stats.heap_allocsz_bytes * 1.0 / (1024 * 1024 * 1024));
+    }
+}
+
+static inline double work_space_init_seconds(uint64_t *tsc)
+{
+    uint64_t begin = *tsc;
+
+    *tsc = rte_rdtsc();
+    return (*tsc - begin) * 1.0 / g_tsc_per_second;
+}
+
+/* the delayed ack fifo of a tcp client, or of a pipelined http server, see tcp_ack_delay() */
+static int work_space_init_ack_delay(struct work_space *ws)
+{
+#ifdef HTTP_PARSE
+    size_t size = TCP_ACK_DELAY_MAX * sizeof(struct tcp_ack_delay_entry);
+    struct config *cfg = ws->cfg;
+
+    if ((cfg->protocol != IPPROTO_TCP) || (cfg->server && (ws->http_pipeline == 0))) {
+        return 0;
+    }
+
+    ws->ack_delay.fifo = rte_zmalloc_socket("ack_delay", size, CACHE_ALIGN_SIZE, rte_socket_id());
+    if (ws->ack_delay.fifo == NULL) {
+        printf("Error: ack_delay allocation failed, memory size %0.2fMB\n", size * 1.0 / (1024 * 1024));
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
+static void work_space_close_ack_delay(struct work_space *ws)
+{
+    if (ws->ack_delay.fifo) {
+        rte_free(ws->ack_delay.fifo);
+        ws->ack_delay.fifo = NULL;
+    }
+}
+
 struct work_space *work_space_new(struct config *cfg, int id)
 {
+    uint64_t tsc = rte_rdtsc();
+    double alloc_sec = 0;
+    double proto_sec = 0;
+    double socket_sec = 0;
+    double rss_sec = 0;
     struct work_space *ws = NULL;
 
     ws = work_space_alloc(cfg, id);
     if (ws == NULL) {
         return NULL;
     }
+    alloc_sec = work_space_init_seconds(&tsc);
 
     g_work_space = ws;
     g_work_space_all[id] = ws;
+    ws->numa_node = rte_socket_id();
     ws->server = cfg->server;
     ws->vlan_id = cfg->vlan_id;
     ws->id = id;
     ws->ipv6 = cfg->af == AF_INET6;
     ws->http = cfg->http;
+    if (cfg->http) {
+        ws->http_pipeline = cfg->pipeline;
+    }
+    ws->gro = cfg->gro;
     ws->flood = cfg->flood;
     ws->neigh_ignore = cfg->neigh_ignore;
     ws->fast_close = cfg->fast_close;
     ws->disable_ack = cfg->disable_ack;
     ws->send_window = (uint32_t)cfg->mss * (uint32_t)cfg->send_window;
+    if (ws->send_window) {
+        ws->tcp_cc = tcp_cc_get(cfg->tcp_cc);
+        ws->tso = g_dev_tx_offload_tcp_tso;
+    }
     ws->payload_size = cfg->payload_size[id];
+    ws->payload_object = cfg->payload_object;
+    ws->timestamps = cfg->timestamps;
+    ws->udp_seq = cfg->udp_seq;
+    ws->dns = cfg->dns;
+    ws->ack_delay.enable = cfg->ack_delay_us > 0;
+    ws->ack_delay.segs = cfg->ack_delay_segs;
+    ws->ack_delay.delay = cfg->ack_delay;
     ws->cfg = cfg;
     ws->tos = cfg->tos;
     ws->tx_queue.tx_burst = cfg->tx_burst;
     work_space_get_port(ws);
+    if ((ws->port->socket >= 0) && (ws->port->socket != ws->numa_node)) {
+        printf("Warning: worker %d is on numa node %d, but port %d is on numa node %d\n",
+            id, ws->numa_node, ws->port_id, ws->port->socket);
+    }
 
     if (work_space_init_change_dip(ws, cfg) < 0) {
         printf("Error: work_space_init_change_dip failed\n");
         goto err;
     }
 
+    if (work_space_init_ack_delay(ws) < 0) {
+        goto err;
+    }
+
     if (tcp_init(ws) < 0) {
         printf("tcp_init error");
         goto err;
@@ -251,15 +472,18 @@ struct work_space *work_space_new(struct config *cfg, int id)
     }
 
     lldp_init(ws);
+    proto_sec = work_space_init_seconds(&tsc);
     if (work_space_open_log(ws) < 0) {
         goto err;
     }
 
     work_space_init_time(ws);
     cpuload_init(&ws->load);
+    work_space_init_seconds(&tsc);
     if (socket_table_init(ws) < 0) {
         goto err;
     }
+    socket_sec = work_space_init_seconds(&tsc);
     net_stats_init(ws);
 
     if (cfg->server) {
@@ -268,7 +492,16 @@ struct work_space *work_space_new(struct config *cfg, int id)
         client_init(ws);
     }
     work_space_wait_all(ws);
-    work_space_init_rss(ws);
+    work_space_init_seconds(&tsc);
+    if (work_space_init_rss(ws) < 0) {
+        goto err;
+    }
+    rss_sec = work_space_init_seconds(&tsc);
+    printf("worker %d init: alloc %0.3fs, templates %0.3fs, socket table %0.3fs, rss index %0.3fs\n",
+        id, alloc_sec, proto_sec, socket_sec, rss_sec);
+    if (id == 0) {
+        work_space_numa_report();
+    }
 
     return ws;
 
@@ -283,6 +516,9 @@ void work_space_close(struct work_space *ws)
         return;
     }
     work_space_close_log(ws);
+    socket_table_close(ws);
+    tcp_reorder_close(ws);
+    work_space_close_ack_delay(ws);
     mbuf_free2_flush();
     if (ws->mmap) {
         munmap(ws, ws->mmap_size);
@@ -423,7 +659,7 @@ void work_space_set_launch_interval(uint64_t launch_interval)
     }
 }
 
-static void work_space_init_rss(struct work_space *ws)
+static int work_space_init_rss(struct work_space *ws)
 {
     int i = 0;
     int idx = 0;
@@ -446,4 +682,10 @@ static void work_space_init_rss(struct work_space *ws)
         idx = ws2->queue_id;
         st->socket_table_hash[idx] = st2;
     }
+
+    if (st->rss && (!ws->server)) {
+        return socket_table_init_rss(ws);
+    }
+
+    return 0;
 }
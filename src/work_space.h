@@ -35,8 +35,10 @@
 #include "tick.h"
 #include "socket.h"
 #include "csum.h"
+#include "tcp_cc.h"
 
 struct socket_table;
+struct tcp_reorder_pool;
 
 extern __thread struct work_space *g_work_space;
 #define g_current_ticks (g_work_space->time.tick.count)
@@ -61,6 +63,11 @@ struct client_launch {
     uint32_t launch_num;
 };
 
+struct tcp_ack_delay_entry {
+    uint64_t deadline;
+    struct socket *sk;
+};
+
 struct work_space {
     /* read mostly */
     uint8_t id;
@@ -74,16 +81,29 @@ struct work_space {
     uint8_t disable_ack:1;
     uint8_t neigh_ignore:1;
     uint8_t mmap:1;
+    uint8_t tso:1;
+    uint8_t gro:1;
+    uint8_t payload_object:1;
+    uint8_t timestamps:1;
+    uint8_t udp_seq:1;
+    uint8_t dns:1;
 
     /* bytes */
     uint32_t send_window;
+    const struct tcp_cc_ops *tcp_cc;
+    uint16_t tso_seg_max;
     size_t mmap_size;
+    size_t mem_size;
+    int numa_node;
 
     uint8_t tos;
+    uint8_t http_pipeline;  /* requests in a segment of a client, see http_set_payload() */
     uint8_t port_id;
     uint8_t queue_id;
 
     uint16_t ip_id;
+    uint16_t dns_id;
+    uint32_t dns_name;  /* the next qname */
     bool lldp;
     bool exit;
     bool stop;
@@ -92,6 +112,10 @@ struct work_space {
     uint32_t vni:24;
     uint32_t vxlan:8;
     uint32_t vtep_ip; /* each queue has a vtep ip */
+    uint16_t udp_ip_csum; /* vxlan: inner ip checksum of the udp template */
+    /* adaptive rto: path estimate of this worker, for sockets without samples */
+    uint32_t srtt;
+    uint32_t rttvar;
     uint32_t payload_size;
     struct tick_time time;
     struct cpuload load;
@@ -108,11 +132,20 @@ struct work_space {
     struct config *cfg;
     struct netif_port *port;
     void (*run_loop)(struct work_space *ws);
+    struct tcp_reorder_pool *reorder;   /* 'rx_reorder' */
 
+    /* delayed ack fifo, see tcp_ack_delay() */
     struct {
-        int next;
-        struct socket *sockets[TCP_ACK_DELAY_MAX];
+        uint32_t head;
+        uint32_t tail;
+        uint8_t segs;   /* ack every 'segs' segments, 0 is no limit */
+        bool enable;    /* 'ack_delay': also pure acks of the client */
+        uint64_t delay; /* tsc */
+        struct tcp_ack_delay_entry *fifo;   /* TCP_ACK_DELAY_MAX entries */
     } ack_delay;
+    struct socket_timer retransmit_timer;
+    struct socket_timer keepalive_timer; /* client only */
+    struct socket_timer timeout_timer;
     struct tx_queue tx_queue;
     struct rte_mbuf *mbuf_rx[NB_RXD];
     struct ip_list  dip_list;
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "unit.h"
+#include "config.h"
+#include "dns.h"
+
+#define UNIT_DNS_ROOM   512
+
+/* "1.example.com" */
+static const uint8_t g_qname[] = "\0011\007example\003com";
+
+static void unit_dns_names_reset(void)
+{
+    free(g_dns_names.data);
+    free(g_dns_names.offset);
+    memset(&g_dns_names, 0, sizeof(g_dns_names));
+}
+
+static int unit_dns_load(bool server, const char *names, uint32_t num)
+{
+    struct config cfg;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.dns = true;
+    cfg.server = server;
+    cfg.dns_name_num = num;
+    if (names) {
+        snprintf(cfg.dns_names, sizeof(cfg.dns_names), "%s", names);
+    }
+
+    unit_dns_names_reset();
+    return dns_load(&cfg);
+}
+
+static uint16_t unit_dns_query(uint8_t *data)
+{
+    UNIT_CHECK(unit_dns_load(false, "example.com", 3) == 0);
+    return dns_query_write(data, 0x1234, 1);
+}
+
+static uint16_t unit_dns_u16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/* "0.example.com", "1.example.com", ... in wire format */
+static void test_dns_names_generate(void)
+{
+    uint8_t data[UNIT_DNS_ROOM];
+    uint16_t len = 0;
+
+    UNIT_CHECK(unit_dns_load(false, "example.com", 3) == 0);
+    UNIT_CHECK(g_dns_names.num == 3);
+    UNIT_CHECK(g_dns_names.offset[2] - g_dns_names.offset[1] == sizeof(g_qname));
+    UNIT_CHECK(memcmp(g_dns_names.data + g_dns_names.offset[1], g_qname, sizeof(g_qname)) == 0);
+    UNIT_CHECK(g_dns_names.query_max == sizeof(struct dns_hdr) + sizeof(g_qname) + DNS_QTAIL_SIZE);
+
+    len = dns_query_write(data, 0x1234, 1);
+    UNIT_CHECK(len == g_dns_names.query_max);
+    UNIT_CHECK(unit_dns_u16(data) == 0x1234);
+    UNIT_CHECK(unit_dns_u16(data + 2) == DNS_FLAG_RD);
+    UNIT_CHECK(unit_dns_u16(data + 4) == 1);
+    UNIT_CHECK(memcmp(data + sizeof(struct dns_hdr), g_qname, sizeof(g_qname)) == 0);
+    UNIT_CHECK(unit_dns_u16(data + len - 4) == DNS_TYPE_A);
+    UNIT_CHECK(unit_dns_u16(data + len - 2) == DNS_CLASS_IN);
+
+    UNIT_CHECK(unit_dns_load(false, "a..com", 1) < 0);
+}
+
+/* one name per line, blanks and comments are skipped */
+static void test_dns_names_read(void)
+{
+    int fd = 0;
+    FILE *fp = NULL;
+    char path[] = "/tmp/dperf-dns-XXXXXX";
+
+    fd = mkstemp(path);
+    UNIT_CHECK(fd >= 0);
+    fp = fdopen(fd, "w");
+    UNIT_CHECK(fp != NULL);
+    fprintf(fp, "# names\n\n  www.example.com  # a comment\nexample.org\n");
+    fclose(fp);
+
+    UNIT_CHECK(unit_dns_load(false, path, 0) == 0);
+    UNIT_CHECK(g_dns_names.num == 2);
+    UNIT_CHECK(memcmp(g_dns_names.data, "\003www\007example\003com", 17) == 0);
+    UNIT_CHECK(memcmp(g_dns_names.data + g_dns_names.offset[1], "\007example\003org", 13) == 0);
+
+    fp = fopen(path, "w");
+    UNIT_CHECK(fp != NULL);
+    fprintf(fp, "# no names\n");
+    fclose(fp);
+    UNIT_CHECK(unit_dns_load(false, path, 0) < 0);
+
+    unlink(path);
+}
+
+/* the id, RD and the question are kept, the answers follow the question */
+static void test_dns_reply(void)
+{
+    uint8_t data[UNIT_DNS_ROOM];
+    uint8_t query[UNIT_DNS_ROOM];
+    uint16_t len = unit_dns_query(data);
+    uint16_t rlen = 0;
+    const uint8_t *an = NULL;
+
+    memcpy(query, data, len);
+    rlen = dns_reply(data, len, sizeof(data), 2);
+    UNIT_CHECK(rlen == len + 2 * DNS_ANSWER_SIZE);
+    UNIT_CHECK(unit_dns_u16(data) == 0x1234);
+    UNIT_CHECK(unit_dns_u16(data + 2) == (DNS_FLAG_QR | DNS_FLAG_AA | DNS_FLAG_RD));
+    UNIT_CHECK(unit_dns_u16(data + 4) == 1);
+    UNIT_CHECK(unit_dns_u16(data + 6) == 2);
+    UNIT_CHECK(memcmp(data + sizeof(struct dns_hdr), query + sizeof(struct dns_hdr),
+                len - sizeof(struct dns_hdr)) == 0);
+
+    /* a pointer to the question, 192.0.2.1 and 192.0.2.2 */
+    an = data + len;
+    UNIT_CHECK((an[0] == 0xc0) && (an[1] == sizeof(struct dns_hdr)));
+    UNIT_CHECK(unit_dns_u16(an + 2) == DNS_TYPE_A);
+    UNIT_CHECK(unit_dns_u16(an + 10) == 4);
+    UNIT_CHECK(memcmp(an + 12, "\300\000\002\001", 4) == 0);
+    UNIT_CHECK(memcmp(an + DNS_ANSWER_SIZE + 12, "\300\000\002\002", 4) == 0);
+
+    len = unit_dns_query(data);
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 0) == len);
+    UNIT_CHECK(unit_dns_u16(data + 6) == 0);
+}
+
+/* additional records (EDNS) are dropped, other types get no answers */
+static void test_dns_reply_query(void)
+{
+    uint8_t data[UNIT_DNS_ROOM];
+    uint16_t len = unit_dns_query(data);
+    const uint8_t opt[] = {0, 0, 41, 0x10, 0, 0, 0, 0, 0, 0, 0};
+
+    data[11] = 1;
+    memcpy(data + len, opt, sizeof(opt));
+    UNIT_CHECK(dns_reply(data, len + sizeof(opt), sizeof(data), 1) == len + DNS_ANSWER_SIZE);
+    UNIT_CHECK(unit_dns_u16(data + 6) == 1);
+    UNIT_CHECK(unit_dns_u16(data + 10) == 0);
+
+    /* AAAA */
+    len = unit_dns_query(data);
+    data[len - 3] = 28;
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 2) == len);
+    UNIT_CHECK(unit_dns_u16(data + 6) == 0);
+}
+
+/* responses, bad questions and short buffers are not answered */
+static void test_dns_reply_invalid(void)
+{
+    uint8_t data[UNIT_DNS_ROOM];
+    uint16_t len = 0;
+
+    len = unit_dns_query(data);
+    UNIT_CHECK(dns_reply(data, sizeof(struct dns_hdr), sizeof(data), 1) == 0);
+    UNIT_CHECK(dns_reply(data, len - 1, sizeof(data), 1) == 0);
+    UNIT_CHECK(dns_reply(data, len, len + DNS_ANSWER_SIZE - 1, 1) == 0);
+    UNIT_CHECK(dns_reply(data, len, len + DNS_ANSWER_SIZE, 1) == len + DNS_ANSWER_SIZE);
+
+    /* the response itself */
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 1) == 0);
+
+    len = unit_dns_query(data);
+    data[5] = 2;
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 1) == 0);
+
+    len = unit_dns_query(data);
+    data[sizeof(struct dns_hdr)] = DNS_LABEL_MAX + 1;
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 1) == 0);
+
+    /* a label beyond the packet */
+    len = unit_dns_query(data);
+    data[sizeof(struct dns_hdr) + 2] = 40;
+    UNIT_CHECK(dns_reply(data, len, sizeof(data), 1) == 0);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_dns_names_generate);
+    UNIT_RUN(test_dns_names_read);
+    UNIT_RUN(test_dns_reply);
+    UNIT_RUN(test_dns_reply_query);
+    UNIT_RUN(test_dns_reply_invalid);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include "unit.h"
+
+/* the scanners are static */
+#include "http_parse.c"
+
+struct config g_config;
+__thread struct net_stats g_net_stats;
+
+#define UNIT_SCAN_SIZE      160
+#define UNIT_SCAN_ROUNDS    20000
+
+/* '\n' and ':' are rare, so lines cross the 16 and 32 byte blocks */
+static void unit_scan_fill(uint8_t *buf, int len)
+{
+    int i = 0;
+    int r = 0;
+
+    for (i = 0; i < len; i++) {
+        r = rand() % 64;
+        if (r == 0) {
+            buf[i] = '\n';
+        } else if (r == 1) {
+            buf[i] = ':';
+        } else if (r == 2) {
+            buf[i] = '\r';
+        } else {
+            buf[i] = 'a' + (r % 26);
+        }
+    }
+}
+
+/* the same '\n' and the same first ':' as the scalar scanner, never past 'end' */
+static void unit_scan_check(http_scan_line_t scan, const uint8_t *p, const uint8_t *end)
+{
+    const uint8_t *lf = NULL;
+    const uint8_t *lf0 = NULL;
+    const uint8_t *colon = NULL;
+    const uint8_t *colon0 = NULL;
+    const uint8_t *preset = p;
+
+    lf0 = http_scan_line_scalar(p, end, &colon0);
+    lf = scan(p, end, &colon);
+    UNIT_CHECK(lf == lf0);
+    UNIT_CHECK(colon == colon0);
+    UNIT_CHECK(lf <= end);
+
+    UNIT_CHECK(scan(p, end, NULL) == lf0);
+
+    /* a colon that is found already is kept */
+    colon = preset;
+    UNIT_CHECK(scan(p, end, &colon) == lf0);
+    UNIT_CHECK(colon == preset);
+}
+
+static void unit_scan_random(http_scan_line_t scan)
+{
+    int i = 0;
+    int len = 0;
+    int offset = 0;
+    uint8_t buf[UNIT_SCAN_SIZE + 1];
+
+    srand(1);
+    for (i = 0; i < UNIT_SCAN_ROUNDS; i++) {
+        len = rand() % UNIT_SCAN_SIZE;
+        offset = rand() % 32;
+        if (offset > len) {
+            offset = len;
+        }
+
+        unit_scan_fill(buf, len);
+        /* a '\n' right after the end must not be seen */
+        buf[len] = '\n';
+        unit_scan_check(scan, buf + offset, buf + len);
+    }
+}
+
+/* a single '\n' and ':' at every position of every block */
+static void unit_scan_positions(http_scan_line_t scan)
+{
+    int i = 0;
+    int j = 0;
+    uint8_t buf[UNIT_SCAN_SIZE + 1];
+
+    for (i = 0; i < 96; i++) {
+        for (j = 0; j < 96; j++) {
+            memset(buf, 'a', sizeof(buf));
+            buf[i] = '\n';
+            buf[j] = ':';
+            unit_scan_check(scan, buf, buf + 96);
+        }
+    }
+}
+
+static void test_http_scan_line_scalar(void)
+{
+    const uint8_t line[] = "Host: a:b\r\nX";
+    const uint8_t *colon = NULL;
+    const uint8_t *end = line + sizeof(line) - 1;
+
+    UNIT_CHECK(http_scan_line_scalar(line, end, &colon) == line + 10);
+    UNIT_CHECK(colon == line + 4);
+    UNIT_CHECK(http_scan_line_scalar(line + 11, end, NULL) == end);
+    UNIT_CHECK(http_scan_line_scalar(end, end, NULL) == end);
+}
+
+#ifdef __SSE2__
+static void test_http_scan_line_sse(void)
+{
+    unit_scan_positions(http_scan_line_sse);
+    unit_scan_random(http_scan_line_sse);
+}
+
+static void test_http_scan_line_avx2(void)
+{
+    if (!__builtin_cpu_supports("avx2")) {
+        printf("no avx2, skipped\n");
+        return;
+    }
+
+    unit_scan_positions(http_scan_line_avx2);
+    unit_scan_random(http_scan_line_avx2);
+}
+#endif
+
+int main(void)
+{
+    UNIT_RUN(test_http_scan_line_scalar);
+#ifdef __SSE2__
+    UNIT_RUN(test_http_scan_line_sse);
+    UNIT_RUN(test_http_scan_line_avx2);
+#endif
+
+    return 0;
+}
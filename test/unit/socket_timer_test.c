@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include <string.h>
+
+#include "unit.h"
+#include "config.h"
+#include "net_stats.h"
+#include "socket.h"
+#include "socket_timer.h"
+#include "work_space.h"
+
+struct config g_config;
+uint64_t g_tsc_per_second;
+__thread struct net_stats g_net_stats;
+__thread struct work_space *g_work_space;
+
+/* a wheel tick is a tsc, the wheel starts in the middle of level 0 */
+#define UNIT_SOCKET_NUM     64
+#define UNIT_TIMER_START    0x1234567ul
+
+static uint64_t g_fired[UNIT_SOCKET_NUM];
+static uint32_t g_order[UNIT_SOCKET_NUM];
+static uint32_t g_fired_num;
+
+static struct work_space *unit_work_space(void)
+{
+    size_t size = sizeof(struct work_space) + ((size_t)UNIT_SOCKET_NUM << SOCKET_SHIFT_TCP);
+    struct work_space *ws = NULL;
+    struct socket_timer *timer = NULL;
+
+    size = (size + CACHE_ALIGN_SIZE - 1) & ~((size_t)CACHE_ALIGN_SIZE - 1);
+    ws = aligned_alloc(CACHE_ALIGN_SIZE, size);
+    UNIT_CHECK(ws != NULL);
+    memset(ws, 0, size);
+
+    ws->socket_table.socket_shift = SOCKET_SHIFT_TCP;
+    ws->socket_table.socket_pool.num = UNIT_SOCKET_NUM;
+    ws->socket_table.timer_deadline = calloc(UNIT_SOCKET_NUM, sizeof(uint64_t));
+    UNIT_CHECK(ws->socket_table.timer_deadline != NULL);
+
+    /* zeroed queues are empty */
+    timer = &ws->retransmit_timer;
+    timer->shift = 0;
+    timer->now = UNIT_TIMER_START;
+    ws->time.tsc = UNIT_TIMER_START;
+
+    g_work_space = ws;
+    memset(g_fired, 0, sizeof(g_fired));
+    g_fired_num = 0;
+
+    return ws;
+}
+
+static void unit_work_space_free(struct work_space *ws)
+{
+    free(ws->socket_table.timer_deadline);
+    free(ws);
+    g_work_space = NULL;
+}
+
+static struct socket *unit_socket(struct work_space *ws, uint32_t idx)
+{
+    return socket_pool_get(&ws->socket_table, idx);
+}
+
+static void unit_timer_handler(struct work_space *ws, struct socket *sk)
+{
+    uint32_t idx = socket_pool_index(&ws->socket_table, sk);
+
+    UNIT_CHECK(g_fired[idx] == 0);
+    g_fired[idx] = work_space_tsc(ws);
+    g_order[g_fired_num++] = idx;
+}
+
+/* tick by tick, so a socket must run exactly at its deadline */
+static void unit_timer_step(struct work_space *ws, uint64_t end_tsc)
+{
+    while (ws->time.tsc < end_tsc) {
+        ws->time.tsc++;
+        socket_timer_run(ws, &ws->retransmit_timer, unit_timer_handler, UINT32_MAX);
+    }
+}
+
+/* every level of the wheel, and the edges of the slots and the cascades */
+static void test_socket_timer_expire(void)
+{
+    uint32_t i = 0;
+    const uint64_t timeouts[] = {1, 5, 255, 256, 257, 300, 1000, 65535, 65536, 65537, 70000,
+        (1ul << 20) + 3, (1ul << 24) + 7};
+    const uint32_t num = sizeof(timeouts) / sizeof(timeouts[0]);
+    struct work_space *ws = unit_work_space();
+    struct socket_timer *timer = &ws->retransmit_timer;
+
+    for (i = 0; i < num; i++) {
+        socket_add_timer(timer, unit_socket(ws, i), UNIT_TIMER_START, timeouts[i]);
+    }
+    UNIT_CHECK(socket_timer_first(timer) != NULL);
+
+    unit_timer_step(ws, UNIT_TIMER_START + timeouts[num - 1] + SOCKET_WHEEL_SLOTS);
+    UNIT_CHECK(g_fired_num == num);
+    for (i = 0; i < num; i++) {
+        UNIT_CHECK(g_fired[i] == UNIT_TIMER_START + timeouts[i]);
+        UNIT_CHECK(g_order[i] == i);
+    }
+    UNIT_CHECK(socket_timer_first(timer) == NULL);
+
+    unit_work_space_free(ws);
+}
+
+/* a jump of the clock runs the due sockets in the order of their deadlines */
+static void test_socket_timer_order(void)
+{
+    uint32_t i = 0;
+    const uint64_t timeouts[] = {1800, 900, 600, 300, 50, 5};
+    const uint32_t num = sizeof(timeouts) / sizeof(timeouts[0]);
+    struct work_space *ws = unit_work_space();
+    struct socket_timer *timer = &ws->retransmit_timer;
+
+    for (i = 0; i < num; i++) {
+        socket_add_timer(timer, unit_socket(ws, i), UNIT_TIMER_START, timeouts[i]);
+    }
+
+    ws->time.tsc = UNIT_TIMER_START + 2000;
+    socket_timer_run(ws, timer, unit_timer_handler, UINT32_MAX);
+    UNIT_CHECK(g_fired_num == num);
+    for (i = 0; i < num; i++) {
+        UNIT_CHECK(g_order[i] == num - 1 - i);
+    }
+
+    unit_work_space_free(ws);
+}
+
+/* a re-armed socket runs at its last deadline, a deleted one never runs */
+static void test_socket_timer_rearm(void)
+{
+    struct work_space *ws = unit_work_space();
+    struct socket_timer *timer = &ws->retransmit_timer;
+    struct socket *sk0 = unit_socket(ws, 0);
+    struct socket *sk1 = unit_socket(ws, 1);
+    struct socket *sk2 = unit_socket(ws, 2);
+
+    socket_add_timer(timer, sk0, UNIT_TIMER_START, 100);
+    socket_add_timer(timer, sk0, UNIT_TIMER_START, 1000);
+
+    /* shortened while it waits on an upper level */
+    socket_add_timer(timer, sk1, UNIT_TIMER_START, 70000);
+    socket_add_timer(timer, sk1, UNIT_TIMER_START + 10, 10);
+
+    socket_add_timer(timer, sk2, UNIT_TIMER_START, 50);
+    socket_del_timer(sk2);
+
+    unit_timer_step(ws, UNIT_TIMER_START + 80000);
+    UNIT_CHECK(g_fired_num == 2);
+    UNIT_CHECK(g_fired[0] == UNIT_TIMER_START + 1000);
+    UNIT_CHECK(g_fired[1] == UNIT_TIMER_START + 20);
+    UNIT_CHECK(g_fired[2] == 0);
+
+    unit_work_space_free(ws);
+}
+
+/* the sockets over the budget wait for the next run */
+static void test_socket_timer_budget(void)
+{
+    uint32_t i = 0;
+    const uint32_t num = 40;
+    struct work_space *ws = unit_work_space();
+    struct socket_timer *timer = &ws->retransmit_timer;
+
+    for (i = 0; i < num; i++) {
+        socket_add_timer(timer, unit_socket(ws, i), UNIT_TIMER_START, 10);
+    }
+
+    ws->time.tsc = UNIT_TIMER_START + 10;
+    socket_timer_run(ws, timer, unit_timer_handler, SOCKET_TIMER_BATCH);
+    UNIT_CHECK(g_fired_num == SOCKET_TIMER_BATCH);
+    socket_timer_run(ws, timer, unit_timer_handler, SOCKET_TIMER_BATCH);
+    UNIT_CHECK(g_fired_num == 2 * SOCKET_TIMER_BATCH);
+    socket_timer_run(ws, timer, unit_timer_handler, SOCKET_TIMER_BATCH);
+    UNIT_CHECK(g_fired_num == num);
+
+    for (i = 0; i < num; i++) {
+        UNIT_CHECK(g_order[i] == i);
+    }
+
+    unit_work_space_free(ws);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_socket_timer_expire);
+    UNIT_RUN(test_socket_timer_order);
+    UNIT_RUN(test_socket_timer_rearm);
+    UNIT_RUN(test_socket_timer_budget);
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#include <string.h>
+
+#include "unit.h"
+#include "mbuf.h"
+#include "net_stats.h"
+#include "socket.h"
+#include "tcp_reorder.h"
+#include "work_space.h"
+
+__thread struct net_stats g_net_stats;
+__thread struct work_space *g_work_space;
+__thread struct mbuf_free_pool g_mbuf_free_pool;
+
+/* the mbufs are never touched, only their addresses are queued and freed */
+#define UNIT_REORDER_DEPTH      4
+#define UNIT_REORDER_BUFFERS    2
+#define UNIT_MBUF_NUM           16
+
+static struct rte_mbuf g_mbufs[UNIT_MBUF_NUM];
+
+static struct work_space *unit_work_space(void)
+{
+    int i = 0;
+    struct work_space *ws = NULL;
+    struct tcp_reorder_pool *pool = NULL;
+
+    ws = calloc(1, sizeof(struct work_space));
+    pool = calloc(1, sizeof(struct tcp_reorder_pool) + (UNIT_REORDER_BUFFERS + 1) * sizeof(struct tcp_reorder));
+    UNIT_CHECK((ws != NULL) && (pool != NULL));
+
+    pool->depth = UNIT_REORDER_DEPTH;
+    pool->free = 1;
+    for (i = 1; i < UNIT_REORDER_BUFFERS; i++) {
+        pool->buffers[i].next = i + 1;
+    }
+    ws->reorder = pool;
+
+    memset(&g_net_stats, 0, sizeof(g_net_stats));
+    memset(&g_mbuf_free_pool, 0, sizeof(g_mbuf_free_pool));
+    g_work_space = ws;
+
+    return ws;
+}
+
+static void unit_work_space_free(struct work_space *ws)
+{
+    free(ws->reorder);
+    free(ws);
+    g_work_space = NULL;
+}
+
+static struct tcp_reorder *unit_reorder(struct work_space *ws, struct socket_cold *skc)
+{
+    UNIT_CHECK(skc->reorder != 0);
+    return &ws->reorder->buffers[skc->reorder];
+}
+
+/* the mbuf of each sequence is the mbuf of the same index */
+static void unit_reorder_check(struct work_space *ws, struct socket_cold *skc, const uint32_t *seqs, int num)
+{
+    int i = 0;
+    struct tcp_reorder *ro = unit_reorder(ws, skc);
+
+    UNIT_CHECK(ro->num == num);
+    for (i = 0; i < num; i++) {
+        UNIT_CHECK(ro->seq[i] == seqs[i]);
+        UNIT_CHECK(ro->mbufs[i] == &g_mbufs[seqs[i] / 100]);
+    }
+}
+
+static int unit_reorder_insert(struct work_space *ws, struct socket_cold *skc, uint32_t seq)
+{
+    return tcp_reorder_insert(ws, skc, &g_mbufs[seq / 100], seq);
+}
+
+static void test_tcp_reorder_insert(void)
+{
+    const uint32_t seqs[] = {100, 200, 300};
+    struct socket_cold skc;
+    struct work_space *ws = unit_work_space();
+
+    memset(&skc, 0, sizeof(skc));
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 300) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 100) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 200) == 0);
+    unit_reorder_check(ws, &skc, seqs, 3);
+    UNIT_CHECK(g_net_stats.tcp_reorder == 3);
+    UNIT_CHECK(g_net_stats.tcp_reorder_drop == 0);
+
+    unit_work_space_free(ws);
+}
+
+/* a retransmission is rejected without touching the queue, the caller frees it */
+static void test_tcp_reorder_duplicate(void)
+{
+    const uint32_t seqs[] = {100, 200, 300};
+    struct socket_cold skc;
+    struct work_space *ws = unit_work_space();
+
+    memset(&skc, 0, sizeof(skc));
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 100) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 200) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 300) == 0);
+
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 100) < 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 200) < 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 300) < 0);
+    unit_reorder_check(ws, &skc, seqs, 3);
+    UNIT_CHECK(g_net_stats.tcp_reorder_drop == 3);
+
+    /* every queued mbuf is freed once */
+    tcp_reorder_free(ws, &skc);
+    UNIT_CHECK(skc.reorder == 0);
+    UNIT_CHECK(g_mbuf_free_pool.num == 3);
+    UNIT_CHECK(g_mbuf_free_pool.mbufs[0] == &g_mbufs[1]);
+    UNIT_CHECK(g_mbuf_free_pool.mbufs[1] == &g_mbufs[2]);
+    UNIT_CHECK(g_mbuf_free_pool.mbufs[2] == &g_mbufs[3]);
+
+    unit_work_space_free(ws);
+}
+
+/* older segments were retransmitted and are freed, the buffer is returned when empty */
+static void test_tcp_reorder_pop(void)
+{
+    const uint32_t seqs[] = {300};
+    struct socket_cold skc;
+    struct work_space *ws = unit_work_space();
+
+    memset(&skc, 0, sizeof(skc));
+    UNIT_CHECK(tcp_reorder_pop(ws, &skc, 100) == NULL);
+
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 100) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 200) == 0);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc, 300) == 0);
+
+    UNIT_CHECK(tcp_reorder_pop(ws, &skc, 50) == NULL);
+    UNIT_CHECK(g_mbuf_free_pool.num == 0);
+
+    UNIT_CHECK(tcp_reorder_pop(ws, &skc, 200) == &g_mbufs[2]);
+    UNIT_CHECK(g_mbuf_free_pool.num == 1);
+    UNIT_CHECK(g_mbuf_free_pool.mbufs[0] == &g_mbufs[1]);
+    unit_reorder_check(ws, &skc, seqs, 1);
+
+    UNIT_CHECK(tcp_reorder_pop(ws, &skc, 300) == &g_mbufs[3]);
+    UNIT_CHECK(skc.reorder == 0);
+    UNIT_CHECK(ws->reorder->free == 1);
+    UNIT_CHECK(g_mbuf_free_pool.num == 1);
+
+    unit_work_space_free(ws);
+}
+
+/* sequences are compared modulo 2^32 */
+static void test_tcp_reorder_wrap(void)
+{
+    struct socket_cold skc;
+    struct tcp_reorder *ro = NULL;
+    struct work_space *ws = unit_work_space();
+
+    memset(&skc, 0, sizeof(skc));
+    UNIT_CHECK(tcp_reorder_insert(ws, &skc, &g_mbufs[1], 0x10) == 0);
+    UNIT_CHECK(tcp_reorder_insert(ws, &skc, &g_mbufs[0], 0xfffffff0) == 0);
+
+    ro = unit_reorder(ws, &skc);
+    UNIT_CHECK(ro->seq[0] == 0xfffffff0);
+    UNIT_CHECK(ro->seq[1] == 0x10);
+
+    UNIT_CHECK(tcp_reorder_pop(ws, &skc, 0x10) == &g_mbufs[1]);
+    UNIT_CHECK(g_mbuf_free_pool.num == 1);
+    UNIT_CHECK(g_mbuf_free_pool.mbufs[0] == &g_mbufs[0]);
+
+    unit_work_space_free(ws);
+}
+
+/* a full queue and an empty pool drop, the caller still owns the mbuf */
+static void test_tcp_reorder_full(void)
+{
+    int i = 0;
+    struct socket_cold skc[UNIT_REORDER_BUFFERS + 1];
+    struct work_space *ws = unit_work_space();
+
+    memset(skc, 0, sizeof(skc));
+    for (i = 1; i <= UNIT_REORDER_DEPTH; i++) {
+        UNIT_CHECK(unit_reorder_insert(ws, &skc[0], i * 100) == 0);
+    }
+    UNIT_CHECK(unit_reorder_insert(ws, &skc[0], 900) < 0);
+    UNIT_CHECK(unit_reorder(ws, &skc[0])->num == UNIT_REORDER_DEPTH);
+
+    for (i = 1; i < UNIT_REORDER_BUFFERS; i++) {
+        UNIT_CHECK(unit_reorder_insert(ws, &skc[i], 100) == 0);
+    }
+    UNIT_CHECK(unit_reorder_insert(ws, &skc[UNIT_REORDER_BUFFERS], 100) < 0);
+    UNIT_CHECK(skc[UNIT_REORDER_BUFFERS].reorder == 0);
+    UNIT_CHECK(g_net_stats.tcp_reorder_drop == 2);
+    UNIT_CHECK(g_mbuf_free_pool.num == 0);
+
+    /* a returned buffer is reused */
+    tcp_reorder_free(ws, &skc[0]);
+    UNIT_CHECK(unit_reorder_insert(ws, &skc[UNIT_REORDER_BUFFERS], 100) == 0);
+
+    unit_work_space_free(ws);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_tcp_reorder_insert);
+    UNIT_RUN(test_tcp_reorder_duplicate);
+    UNIT_RUN(test_tcp_reorder_pop);
+    UNIT_RUN(test_tcp_reorder_wrap);
+    UNIT_RUN(test_tcp_reorder_full);
+
+    return 0;
+}
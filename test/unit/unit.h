@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022-2023 Jianzhang Peng. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Jianzhang Peng (pengjianzhang@gmail.com)
+ */
+
+#ifndef __UNIT_H
+#define __UNIT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * host-side drivers of the data structures, no EAL or ports are needed.
+ * A driver exits with 1 on the first failed check.
+ * */
+#define UNIT_CHECK(cond) do {                                           \
+    if (!(cond)) {                                                      \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define UNIT_RUN(test) do {                 \
+    test();                                 \
+    printf("%-40s OK\n", #test);            \
+} while (0)
+
+#endif